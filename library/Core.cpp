@@ -24,6 +24,7 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
@@ -46,13 +47,17 @@ distribution.
 #include "Module.h"
 #include "VersionInfoFactory.h"
 #include "VersionInfo.h"
+#include "PerfCounters.h"
 #include "PluginManager.h"
 #include "ModuleFactory.h"
+#include "modules/Clothing.h"
 #include "modules/DFSDL.h"
 #include "modules/DFSteam.h"
 #include "modules/EventManager.h"
 #include "modules/Filesystem.h"
 #include "modules/Gui.h"
+#include "modules/Orders.h"
+#include "modules/RawIndex.h"
 #include "modules/Textures.h"
 #include "modules/World.h"
 #include "modules/Persistence.h"
@@ -73,6 +78,7 @@ using namespace DFHack;
 #include "df/viewscreen_loadgamest.h"
 #include "df/viewscreen_new_regionst.h"
 #include "df/viewscreen_savegamest.h"
+#include "df/viewscreen_update_regionst.h"
 #include <df/graphic.h>
 
 #include <stdio.h>
@@ -146,6 +152,12 @@ struct Core::Private
     bool last_autosave_request{false};
     bool last_manual_save_request{false};
     bool was_load_save{false};
+
+    // see beginImmutableRead
+    std::mutex immutable_mutex;
+    std::condition_variable immutable_cv;
+    int immutable_readers{0};
+    bool immutable_valid{false};
 };
 
 struct CommandDepthCounter
@@ -585,6 +597,48 @@ static std::string sc_event_name (state_change_event id) {
     return "SC_UNKNOWN";
 }
 
+static void print_perf_counters(color_ostream &con)
+{
+    struct Row {
+        std::string name;
+        uint64_t count, total_ns, max_ns, p50_us, p99_us;
+    };
+    std::vector<Row> rows;
+    PerfCounters::forEach([&](const std::string &name, const LatencyHistogram &hist) {
+        if (hist.getCount())
+            rows.push_back({name, hist.getCount(), hist.getTotalNs(), hist.getMaxNs(),
+                            hist.getPercentileUs(50), hist.getPercentileUs(99)});
+    });
+    std::vector<std::pair<std::string, uint64_t>> events;
+    PerfCounters::forEachCounter([&](const std::string &name, const EventCounter &counter) {
+        if (counter.get())
+            events.emplace_back(name, counter.get());
+    });
+    if (rows.empty() && events.empty()) {
+        con.print("No samples recorded.\n");
+        return;
+    }
+    if (!rows.empty()) {
+        std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+            return a.total_ns > b.total_ns;
+        });
+        con.print("%-56s %10s %10s %9s %8s %8s %9s\n",
+                  "counter", "calls", "total ms", "avg us", "p50 us", "p99 us", "max us");
+        for (auto &row : rows) {
+            con.print("%-56s %10llu %10.1f %9.1f %8llu %8llu %9.1f\n", row.name.c_str(),
+                      (unsigned long long)row.count, row.total_ns / 1e6, row.total_ns / 1e3 / row.count,
+                      (unsigned long long)row.p50_us, (unsigned long long)row.p99_us, row.max_ns / 1e3);
+        }
+    }
+    if (!events.empty()) {
+        if (!rows.empty())
+            con.print("\n");
+        con.print("%-56s %10s\n", "event", "count");
+        for (auto &[name, count] : events)
+            con.print("%-56s %10llu\n", name.c_str(), (unsigned long long)count);
+    }
+}
+
 void help_helper(color_ostream &con, const std::string &entry_name) {
     CoreSuspender suspend;
     auto L = Lua::Core::State;
@@ -1181,6 +1235,23 @@ command_result Core::runCommand(color_ostream &con, const std::string &first_, s
             return CR_WRONG_USAGE;
         }
     }
+    else if (first == "devel/perf")
+    {
+        if (parts.empty())
+        {
+            print_perf_counters(con);
+        }
+        else if (parts.size() == 1 && parts[0] == "reset")
+        {
+            PerfCounters::resetAll();
+            con.print("Performance counters reset.\n");
+        }
+        else
+        {
+            con << "Usage: devel/perf [reset]" << std::endl;
+            return CR_WRONG_USAGE;
+        }
+    }
     else if (first == "devel/dump-rpc")
     {
         if (parts.size() == 1)
@@ -1438,6 +1509,7 @@ Core::Core() :
     hotkey_set = NO;
     last_world_data_ptr = NULL;
     last_local_map_ptr = NULL;
+    update_count = 1;
     last_pause_state = false;
     top_viewscreen = NULL;
 
@@ -1926,6 +1998,15 @@ void Core::doUpdate(color_ostream &out)
         new_mapdata = df::global::world->map.block_index;
     }
 
+    // once a world is fully loaded, raws and world data can only go away
+    // through the load/save screens, which DF doesn't process until this
+    // returns. While a world is being generated or updated, DF is still
+    // appending to them, so readers have to suspend.
+    bool world_settled = new_wdata &&
+        !Gui::getViewscreenByType<df::viewscreen_new_regionst>() &&
+        !Gui::getViewscreenByType<df::viewscreen_update_regionst>();
+    setImmutableDataValid(world_settled);
+
     // if the world changes
     if (new_wdata != last_world_data_ptr)
     {
@@ -1978,6 +2059,32 @@ void Core::doUpdate(color_ostream &out)
     out << std::flush;
 }
 
+bool Core::beginImmutableRead()
+{
+    std::lock_guard<std::mutex> lock(d->immutable_mutex);
+    if (!d->immutable_valid)
+        return false;
+    d->immutable_readers++;
+    return true;
+}
+
+void Core::endImmutableRead()
+{
+    std::lock_guard<std::mutex> lock(d->immutable_mutex);
+    if (--d->immutable_readers == 0)
+        d->immutable_cv.notify_all();
+}
+
+void Core::setImmutableDataValid(bool valid)
+{
+    std::unique_lock<std::mutex> lock(d->immutable_mutex);
+    if (d->immutable_valid == valid)
+        return;
+    d->immutable_valid = valid;
+    if (!valid)
+        d->immutable_cv.wait(lock, [this]() { return d->immutable_readers == 0; });
+}
+
 // should always be from simulation thread!
 int Core::Update()
 {
@@ -2008,6 +2115,7 @@ int Core::Update()
 };
 
 extern bool buildings_do_onupdate;
+extern uint32_t buildings_update_count;
 void buildings_onStateChange(color_ostream &out, state_change_event event);
 void buildings_onUpdate(color_ostream &out);
 
@@ -2017,7 +2125,16 @@ void Core::onUpdate(color_ostream &out)
 {
     Gui::clearFocusStringCache();
 
-    EventManager::manageEvents(out);
+    static LatencyHistogram &events_latency = PerfCounters::get("update/events");
+    static LatencyHistogram &lua_timers_latency = PerfCounters::get("update/lua-timers");
+
+    {
+        PerfTimer timer(events_latency);
+        EventManager::manageEvents(out);
+    }
+
+    ++update_count;
+    ++buildings_update_count;
 
     // convert building reagents
     if (buildings_do_onupdate && (++buildings_timer & 1))
@@ -2027,7 +2144,10 @@ void Core::onUpdate(color_ostream &out)
     plug_mgr->OnUpdate(out);
 
     // process timers in lua
-    Lua::Core::onUpdate(out);
+    {
+        PerfTimer timer(lua_timers_latency);
+        Lua::Core::onUpdate(out);
+    }
 }
 
 void getFilesWithPrefixAndSuffix(const std::string& folder, const std::string& prefix, const std::string& suffix, std::vector<std::string>& result) {
@@ -2253,6 +2373,10 @@ void Core::onStateChange(color_ostream &out, state_change_event event)
     if (event == SC_WORLD_UNLOADED)
     {
         Persistence::Internal::clear(out);
+        Clothing::invalidate();
+        Maps::resetDesignationCensus();
+        Orders::invalidate();
+        RawIndex::invalidate();
         loadModScriptPaths(out);
         auto L = Lua::Core::State;
         Lua::StackUnwinder top(L);
@@ -45,6 +45,7 @@ distribution.
 #include "modules/Burrows.h"
 #include "modules/Constructions.h"
 #include "modules/Designations.h"
+#include "modules/EventManager.h"
 #include "modules/Filesystem.h"
 #include "modules/Gui.h"
 #include "modules/Items.h"
@@ -55,6 +56,7 @@ distribution.
 #include "modules/Materials.h"
 #include "modules/Military.h"
 #include "modules/Random.h"
+#include "modules/RawIndex.h"
 #include "modules/Screen.h"
 #include "modules/Textures.h"
 #include "modules/Translation.h"
@@ -65,6 +67,7 @@ distribution.
 #include "LuaTools.h"
 
 #include "MiscUtils.h"
+#include "PerfCounters.h"
 
 #include "df/activity_entry.h"
 #include "df/activity_event.h"
@@ -433,6 +436,31 @@ static int dfhack_matinfo_find(lua_State *state)
     return 1;
 }
 
+static int dfhack_matinfo_findAll(lua_State *state)
+{
+    luaL_checktype(state, 1, LUA_TTABLE);
+    int count = lua_rawlen(state, 1);
+
+    lua_createtable(state, 0, count);
+    for (int i = 1; i <= count; i++)
+    {
+        lua_rawgeti(state, 1, i);
+        const char *token = lua_tostring(state, -1);
+        if (!token)
+            luaL_error(state, "token #%d is not a string", i);
+
+        MaterialInfo info;
+        if (info.find(token))
+        {
+            Lua::Push(state, info);
+            lua_setfield(state, -3, token);
+        }
+        lua_pop(state, 1);
+    }
+
+    return 1;
+}
+
 static bool decode_matinfo(lua_State *state, MaterialInfo *info, bool numpair = false)
 {
     int curtop = lua_gettop(state);
@@ -564,6 +592,7 @@ static int dfhack_matinfo_matches(lua_State *state)
 
 static const luaL_Reg dfhack_matinfo_funcs[] = {
     { "find", dfhack_matinfo_find },
+    { "findAll", dfhack_matinfo_findAll },
     { "decode", dfhack_matinfo_decode },
     { "getToken", dfhack_matinfo_getToken },
     { "toString", dfhack_matinfo_toString },
@@ -1914,6 +1943,49 @@ static int units_getCitizens(lua_State *L) {
     return 0;
 }
 
+static int units_queryUnits(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    Units::UnitQuery query;
+    lua_pushnil(L);
+    while (lua_next(L, 1)) {
+        if (lua_type(L, -2) != LUA_TSTRING)
+            luaL_error(L, "unit filter names must be strings");
+        std::string name = lua_tostring(L, -2);
+        if (name == "race") {
+            if (lua_type(L, -1) == LUA_TNUMBER)
+                query.race((int32_t)lua_tointeger(L, -1));
+            else
+                query.race(std::string(luaL_checkstring(L, -1)));
+        }
+        else if (name == "age")
+            query.age(luaL_checkint(L, -1));
+        else if (name == "minage")
+            query.minAge(luaL_checknumber(L, -1));
+        else if (name == "maxage")
+            query.maxAge(luaL_checknumber(L, -1));
+        else if (!query.addNamed(name, !lua_toboolean(L, -1)))
+            luaL_error(L, "unknown unit filter: %s", name.c_str());
+        lua_pop(L, 1);
+    }
+
+    std::vector<df::unit *> units;
+    if (lua_isnoneornil(L, 2))
+        query.select(units, world->units.active);
+    else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        std::vector<df::unit *> candidates;
+        lua_pushnil(L);
+        while (lua_next(L, 2)) {
+            candidates.push_back(Lua::CheckDFObject<df::unit>(L, -1));
+            lua_pop(L, 1);
+        }
+        query.select(units, candidates);
+    }
+    Lua::PushVector(L, units);
+    return 1;
+}
+
 static int units_getUnitsByNobleRole(lua_State *L) {
     std::string role_name = luaL_checkstring(L, -1);
     std::vector<df::unit *> units;
@@ -1946,6 +2018,7 @@ static const luaL_Reg dfhack_units_funcs[] = {
     { "getNoblePositions", units_getNoblePositions },
     { "getUnitsInBox", units_getUnitsInBox },
     { "getCitizens", units_getCitizens },
+    { "queryUnits", units_queryUnits },
     { "getUnitsByNobleRole", units_getUnitsByNobleRole},
     { "getStressCutoffs", units_getStressCutoffs },
     { "assignTrainer", units_assignTrainer },
@@ -2211,6 +2284,18 @@ static int maps_getBiomeType(lua_State *L)
     return 1;
 }
 
+static int maps_getDesignationCounts(lua_State *L)
+{
+    auto &counts = Maps::getDesignationCounts();
+    lua_createtable(L, 0, 5);
+    Lua::SetField(L, counts.dig, -1, "dig");
+    Lua::SetField(L, counts.marked, -1, "marked");
+    Lua::SetField(L, counts.smooth, -1, "smooth");
+    Lua::SetField(L, counts.track, -1, "track");
+    Lua::SetField(L, counts.total(), -1, "total");
+    return 1;
+}
+
 static const luaL_Reg dfhack_maps_funcs[] = {
     { "isValidTilePos", maps_isValidTilePos },
     { "isTileVisible", maps_isTileVisible },
@@ -2222,6 +2307,7 @@ static const luaL_Reg dfhack_maps_funcs[] = {
     { "getTileBiomeRgn", maps_getTileBiomeRgn },
     { "getPlantAtTile", maps_getPlantAtTile },
     { "getBiomeType", maps_getBiomeType },
+    { "getDesignationCounts", maps_getDesignationCounts },
     { NULL, NULL }
 };
 
@@ -2285,6 +2371,10 @@ static const LuaWrapper::FunctionReg dfhack_burrows_module[] = {
     WRAPN(setAssignedBlockTile, burrows_setAssignedBlockTile),
     WRAPM(Burrows, isAssignedTile),
     WRAPM(Burrows, setAssignedTile),
+    WRAPM(Burrows, unionTiles),
+    WRAPM(Burrows, intersectTiles),
+    WRAPM(Burrows, subtractTiles),
+    WRAPM(Burrows, setTilesInBox),
     { NULL, NULL }
 };
 
@@ -2349,6 +2439,19 @@ static int buildings_findCivzonesAt(lua_State *L)
     return 1;
 }
 
+static int buildings_findCivzonesIn(lua_State *L)
+{
+    df::coord pos1, pos2;
+    Lua::CheckDFAssign(L, &pos1, 1);
+    Lua::CheckDFAssign(L, &pos2, 2);
+    std::vector<df::building_civzonest*> pvec;
+    if (Buildings::findCivzonesIn(&pvec, pos1, pos2))
+        Lua::PushVector(L, pvec);
+    else
+        lua_pushnil(L);
+    return 1;
+}
+
 static int buildings_findPenPitAt(lua_State *L)
 {
     auto pos = CheckCoordXYZ(L, 1, true);
@@ -2420,6 +2523,7 @@ static int buildings_getCageOccupants(lua_State *state)
 static const luaL_Reg dfhack_buildings_funcs[] = {
     { "findAtTile", buildings_findAtTile },
     { "findCivzonesAt", buildings_findCivzonesAt },
+    { "findCivzonesIn", buildings_findCivzonesIn },
     { "getCorrectSize", buildings_getCorrectSize },
     CWRAP(setSize, buildings_setSize),
     CWRAP(getStockpileContents, buildings_getStockpileContents),
@@ -2828,6 +2932,16 @@ static const LuaWrapper::FunctionReg dfhack_kitchen_module[] = {
     {NULL, NULL}
 };
 
+/***** Raws module *****/
+
+static const LuaWrapper::FunctionReg dfhack_raws_module[] = {
+    WRAPM(RawIndex, findInorganic),
+    WRAPM(RawIndex, findPlant),
+    WRAPM(RawIndex, findCreature),
+    WRAPM(RawIndex, findItemSubtype),
+    {NULL, NULL}
+};
+
 /***** Console module *****/
 
 namespace console {
@@ -3637,6 +3751,51 @@ static int internal_md5file(lua_State *L)
     }
 }
 
+static int internal_getTickQueueStats(lua_State *L)
+{
+    lua_newtable(L);
+    Lua::TableInsert(L, "depth", EventManager::getTickQueueDepth());
+    lua_newtable(L);
+    for (auto &[plugin, count] : EventManager::getTickCountsByPlugin())
+        Lua::TableInsert(L, plugin ? plugin->getName() : std::string(), count);
+    lua_setfield(L, -2, "plugins");
+    return 1;
+}
+
+static int internal_getPerfCounters(lua_State *L)
+{
+    lua_newtable(L);
+    PerfCounters::forEach([&](const std::string &name, const LatencyHistogram &hist) {
+        lua_newtable(L);
+        Lua::TableInsert(L, "count", hist.getCount());
+        Lua::TableInsert(L, "total_us", hist.getTotalNs() / 1000);
+        Lua::TableInsert(L, "max_us", hist.getMaxNs() / 1000);
+        Lua::TableInsert(L, "p50_us", hist.getPercentileUs(50));
+        Lua::TableInsert(L, "p99_us", hist.getPercentileUs(99));
+        lua_createtable(L, LatencyHistogram::NUM_BUCKETS, 0);
+        for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i)
+            Lua::TableInsert(L, i + 1, hist.getBucket(i));
+        lua_setfield(L, -2, "buckets");
+        lua_setfield(L, -2, name.c_str());
+    });
+    return 1;
+}
+
+static int internal_getPerfEventCounters(lua_State *L)
+{
+    lua_newtable(L);
+    PerfCounters::forEachCounter([&](const std::string &name, const EventCounter &counter) {
+        Lua::TableInsert(L, name, counter.get());
+    });
+    return 1;
+}
+
+static int internal_resetPerfCounters(lua_State *L)
+{
+    PerfCounters::resetAll();
+    return 0;
+}
+
 static int internal_getSuppressDuplicateKeyboardEvents(lua_State *L) {
     Lua::Push(L, Core::getInstance().getSuppressDuplicateKeyboardEvents());
     return 1;
@@ -3676,6 +3835,10 @@ static const luaL_Reg dfhack_internal_funcs[] = {
     { "getCommandDescription", internal_getCommandDescription },
     { "threadid", internal_threadid },
     { "md5File", internal_md5file },
+    { "getTickQueueStats", internal_getTickQueueStats },
+    { "getPerfCounters", internal_getPerfCounters },
+    { "getPerfEventCounters", internal_getPerfEventCounters },
+    { "resetPerfCounters", internal_resetPerfCounters },
     { "getSuppressDuplicateKeyboardEvents", internal_getSuppressDuplicateKeyboardEvents },
     { "setSuppressDuplicateKeyboardEvents", internal_setSuppressDuplicateKeyboardEvents },
     { NULL, NULL }
@@ -3711,6 +3874,7 @@ void OpenDFHackApi(lua_State *state)
     OpenModule(state, "filesystem", dfhack_filesystem_module, dfhack_filesystem_funcs);
     OpenModule(state, "designations", dfhack_designations_module, dfhack_designations_funcs);
     OpenModule(state, "kitchen", dfhack_kitchen_module);
+    OpenModule(state, "raws", dfhack_raws_module);
     OpenModule(state, "console", dfhack_console_module);
     OpenModule(state, "internal", dfhack_internal_module, dfhack_internal_funcs);
 }
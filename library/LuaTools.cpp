@@ -24,6 +24,7 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
 #include <csignal>
 #include <string>
 #include <vector>
@@ -1937,10 +1938,118 @@ lua_State *DFHack::Lua::Open(color_ostream &out, lua_State *state)
     return state;
 }
 
+/*
+ * Hashed timing wheel for the timers queued by dfhack.timeout and
+ * dfhack.interval. Timers are filed into the slot for their due time modulo
+ * NUM_SLOTS; timers further out than one revolution simply stay put until
+ * their slot comes around with the right time. Slots keep their capacity, so
+ * once the wheel has warmed up, queueing and re-arming timers does not
+ * allocate.
+ */
+class LuaTimerWheel {
+public:
+    struct Due {
+        int when;
+        int id;
+        bool once;
+    };
+
+    bool empty() const { return count == 0; }
+
+    void schedule(int now, int when, int id, int interval) {
+        // an empty wheel has not been advanced, so bring it to the present
+        if (!count)
+            last = now;
+        slots[when & SLOT_MASK].push_back(Timer{when, id, interval});
+        ++count;
+    }
+
+    void clear() {
+        for (auto &slot : slots)
+            slot.clear();
+        count = 0;
+    }
+
+    template<typename F> void forEach(F fn) const {
+        for (auto &slot : slots)
+            for (auto &timer : slot)
+                fn(timer.id);
+    }
+
+    // Appends the timers that are due at or before bound to the due list.
+    // Timers whose callback has been cleared from the registry table at
+    // index table are dropped, and repeating timers are re-armed.
+    void collect(lua_State *L, int table, int bound, std::vector<Due> &due) {
+        if (!count) {
+            last = bound;
+            return;
+        }
+        if (bound <= last)
+            return;
+
+        size_t first = due.size();
+        int span = std::min(bound - last, NUM_SLOTS);
+        for (int i = 1; i <= span; i++) {
+            int slot_idx = (last + i) & SLOT_MASK;
+            auto &slot = slots[slot_idx];
+            size_t keep = 0;
+            for (size_t j = 0; j < slot.size(); j++) {
+                Timer timer = slot[j];
+                if (timer.when > bound) {
+                    slot[keep++] = timer;
+                    continue;
+                }
+
+                lua_rawgeti(L, table, timer.id);
+                bool cancelled = lua_isnil(L, -1);
+                lua_pop(L, 1);
+                if (cancelled || !timer.interval) {
+                    if (!cancelled)
+                        due.push_back(Due{timer.when, timer.id, true});
+                    --count;
+                    continue;
+                }
+
+                due.push_back(Due{timer.when, timer.id, false});
+                // re-arm for the first period after bound, so a repeating
+                // timer fires once per batch and keeps its phase after a gap
+                timer.when += ((bound - timer.when) / timer.interval + 1) * timer.interval;
+                if ((timer.when & SLOT_MASK) == slot_idx)
+                    slot[keep++] = timer;
+                else
+                    slots[timer.when & SLOT_MASK].push_back(timer);
+            }
+            slot.resize(keep);
+        }
+        // slots are visited in wheel order, so after a gap timers that are
+        // more than a revolution apart come out of order; put them back in
+        // due order, keeping the queueing order of timers due together
+        if (span > 1)
+            std::stable_sort(due.begin() + first, due.end(),
+                [](const Due &a, const Due &b) { return a.when < b.when; });
+        last = bound;
+    }
+
+private:
+    struct Timer {
+        int when;
+        int id;
+        int interval; // 0 for one-shot timers
+    };
+
+    static constexpr int NUM_SLOTS = 256;
+    static constexpr int SLOT_MASK = NUM_SLOTS - 1;
+
+    std::vector<Timer> slots[NUM_SLOTS];
+    size_t count = 0;
+    int last = 0;
+};
+
 static int next_timeout_id = 0;
 static int frame_idx = 0;
-static std::multimap<int,int> frame_timers;
-static std::multimap<int,int> tick_timers;
+static LuaTimerWheel frame_timers;
+static LuaTimerWheel tick_timers;
+static std::vector<LuaTimerWheel::Due> due_timers;
 
 int DFHACK_TIMEOUTS_TOKEN = 0;
 
@@ -1948,7 +2057,7 @@ static const char *const timeout_modes[] = {
     "frames", "ticks", "days", "months", "years", NULL
 };
 
-int dfhack_timeout(lua_State *L)
+static int queue_timer(lua_State *L, bool repeating)
 {
     using df::global::world;
     using df::global::enabler;
@@ -1987,10 +2096,11 @@ int dfhack_timeout(lua_State *L)
 
     // Queue the timeout
     int id = next_timeout_id++;
+    int interval = repeating ? delta : 0;
     if (mode)
-        tick_timers.insert(std::pair<int,int>(world->frame_counter+delta, id));
+        tick_timers.schedule(world->frame_counter, world->frame_counter+delta, id, interval);
     else
-        frame_timers.insert(std::pair<int,int>(frame_idx+delta, id));
+        frame_timers.schedule(frame_idx, frame_idx+delta, id, interval);
 
     lua_rawgetp(L, LUA_REGISTRYINDEX, &DFHACK_TIMEOUTS_TOKEN);
     lua_swap(L);
@@ -2000,6 +2110,16 @@ int dfhack_timeout(lua_State *L)
     return 1;
 }
 
+int dfhack_timeout(lua_State *L)
+{
+    return queue_timer(L, false);
+}
+
+static int dfhack_interval(lua_State *L)
+{
+    return queue_timer(L, true);
+}
+
 int dfhack_timeout_active(lua_State *L)
 {
     int id = luaL_optint(L, 1, -1);
@@ -2024,18 +2144,17 @@ int dfhack_timeout_active(lua_State *L)
     return 1;
 }
 
-static void cancel_timers(std::multimap<int,int> &timers)
+static void cancel_timers(LuaTimerWheel &timers)
 {
     using Lua::Core::State;
 
     Lua::StackUnwinder frame(State);
     lua_rawgetp(State, LUA_REGISTRYINDEX, &DFHACK_TIMEOUTS_TOKEN);
 
-    for (auto it = timers.begin(); it != timers.end(); ++it)
-    {
+    timers.forEach([&](int id) {
         lua_pushnil(State);
-        lua_rawseti(State, frame[1], it->second);
-    }
+        lua_rawseti(State, frame[1], id);
+    });
 
     timers.clear();
 }
@@ -2057,42 +2176,65 @@ void DFHack::Lua::Core::onStateChange(color_ostream &out, int code) {
     Lua::Event::Invoke(out, State, (void*)onStateChange, 1);
 }
 
-static void run_timers(color_ostream &out, lua_State *L,
-                       std::multimap<int,int> &timers, int table, int bound)
+/*
+ * Runs every collected timer inside a single protected call. Each callback
+ * still gets its own lua_pcall so that one failing timer is reported and
+ * does not prevent the rest of the batch from running.
+ */
+static int run_due_timers(lua_State *L)
 {
-    while (!timers.empty() && timers.begin()->first <= bound)
-    {
-        int id = timers.begin()->second;
-        timers.erase(timers.begin());
+    color_ostream *out = Lua::GetOutput(L);
+    int table = 1;
+    lua_pushcfunction(L, dfhack_onerror);
+    int errfunc = lua_gettop(L);
 
-        lua_rawgeti(L, table, id);
+    for (auto &due : due_timers)
+    {
+        // an earlier callback in this batch may have cancelled this one
+        lua_rawgeti(L, table, due.id);
 
         if (lua_isnil(L, -1))
+        {
             lua_pop(L, 1);
-        else
+            continue;
+        }
+
+        if (due.once)
         {
             lua_pushnil(L);
-            lua_rawseti(L, table, id);
-
-            Lua::SafeCall(out, L, 0, 0);
+            lua_rawseti(L, table, due.id);
         }
+
+        if (lua_pcall(L, 0, 0, errfunc) != LUA_OK)
+            report_error(L, out, true);
     }
+
+    return 0;
 }
 
 void DFHack::Lua::Core::onUpdate(color_ostream &out)
 {
     using df::global::world;
 
+    ++frame_idx;
+
     if (frame_timers.empty() && tick_timers.empty())
         return;
 
     Lua::StackUnwinder frame(State);
     lua_rawgetp(State, LUA_REGISTRYINDEX, &DFHACK_TIMEOUTS_TOKEN);
 
-    run_timers(out, State, frame_timers, frame[1], ++frame_idx);
-
+    due_timers.clear();
+    frame_timers.collect(State, frame[1], frame_idx, due_timers);
     if (world)
-        run_timers(out, State, tick_timers, frame[1], world->frame_counter);
+        tick_timers.collect(State, frame[1], world->frame_counter, due_timers);
+
+    if (due_timers.empty())
+        return;
+
+    lua_pushcfunction(State, run_due_timers);
+    lua_pushvalue(State, frame[1]);
+    Lua::SafeCall(out, State, 1, 0);
 }
 
 bool DFHack::Lua::Core::Init(color_ostream &out)
@@ -2123,6 +2265,8 @@ static void Lua::Core::InitCoreContext(color_ostream &out)
     lua_setfield(State, -2, "timeout");
     lua_pushcfunction(State, dfhack_timeout_active);
     lua_setfield(State, -2, "timeout_active");
+    lua_pushcfunction(State, dfhack_interval);
+    lua_setfield(State, -2, "interval");
 
     lua_pop(State, 1);
 
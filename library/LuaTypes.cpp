@@ -27,6 +27,8 @@ distribution.
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "MemAccess.h"
 #include "Core.h"
@@ -605,6 +607,75 @@ static void write_field(lua_State *state, const struct_field_info *field, void *
     }
 }
 
+/**
+ * Cheap filter for fields that can never have a union tag, which is almost
+ * all of them: only unions and vectors of unions are tagged.
+ */
+static bool may_have_union_tag(const struct_field_info *field)
+{
+    if (!field->type)
+        return false;
+
+    switch (field->mode)
+    {
+    case struct_field_info::SUBSTRUCT:
+        return field->type->type() == IDTYPE_UNION;
+
+    case struct_field_info::CONTAINER:
+    {
+        if (field->type->type() != IDTYPE_CONTAINER)
+            return false;
+        auto item = ((container_identity*)field->type)->getItemType();
+        return item && item->type() == IDTYPE_UNION;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * find_union_tag searches the field lists by name and builds strings along
+ * the way, so memoize it. Type identities and field descriptors are static
+ * and live as long as the process does.
+ */
+static const struct_field_info *find_union_tag_cached(struct_identity *structure, const struct_field_info *field)
+{
+    typedef std::pair<struct_identity*, const struct_field_info*> key_type;
+    struct key_hash {
+        size_t operator()(const key_type &key) const {
+            return std::hash<const void*>()(key.first) ^ (std::hash<const void*>()(key.second) << 1);
+        }
+    };
+    static std::mutex cache_mutex;
+    static std::unordered_map<key_type, const struct_field_info*, key_hash> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    key_type key(structure, field);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+    return cache[key] = find_union_tag(structure, field);
+}
+
+/**
+ * If the field reference on top of the stack is a tagged union (or vector of
+ * unions), remember where its tag lives.
+ */
+static void attach_union_tag(lua_State *state, int obj, uint8_t *ptr, const struct_field_info *field, const char *mode)
+{
+    if (!may_have_union_tag(field))
+        return;
+
+    auto struct_type = (struct_identity*)get_object_identity(state, obj, mode, false);
+    if (auto tag_field = find_union_tag_cached(struct_type, field))
+    {
+        get_object_ref_header(state, -1)->tag_ptr = ptr + tag_field->offset;
+        get_object_ref_header(state, -1)->tag_identity = tag_field->type;
+        get_object_ref_header(state, -1)->tag_attr = field->extra ? field->extra->union_tag_attr : nullptr;
+    }
+}
+
 /**
  * Metamethod: __index for structures.
  */
@@ -615,16 +686,7 @@ static int meta_struct_index(lua_State *state)
     if (!field)
         return 1;
     read_field(state, field, ptr + field->offset);
-    if (field->mode == struct_field_info::SUBSTRUCT || field->mode == struct_field_info::CONTAINER)
-    {
-        auto struct_type = (struct_identity*)get_object_identity(state, 1, "read", false);
-        if (auto tag_field = find_union_tag(struct_type, field))
-        {
-            get_object_ref_header(state, -1)->tag_ptr = ptr + tag_field->offset;
-            get_object_ref_header(state, -1)->tag_identity = tag_field->type;
-            get_object_ref_header(state, -1)->tag_attr = field->extra ? field->extra->union_tag_attr : nullptr;
-        }
-    }
+    attach_union_tag(state, 1, ptr, field, "read");
     return 1;
 }
 
@@ -640,16 +702,7 @@ static int meta_struct_field_reference(lua_State *state)
     if (!field)
         field_error(state, 2, "builtin property or method", "reference");
     field_reference(state, field, ptr + field->offset);
-    if (field->mode == struct_field_info::SUBSTRUCT || field->mode == struct_field_info::CONTAINER)
-    {
-        auto struct_type = (struct_identity*)get_object_identity(state, 1, "reference", false);
-        if (auto tag_field = find_union_tag(struct_type, field))
-        {
-            get_object_ref_header(state, -1)->tag_ptr = ptr + tag_field->offset;
-            get_object_ref_header(state, -1)->tag_identity = tag_field->type;
-            get_object_ref_header(state, -1)->tag_attr = field->extra ? field->extra->union_tag_attr : nullptr;
-        }
-    }
+    attach_union_tag(state, 1, ptr, field, "reference");
     return 1;
 }
 
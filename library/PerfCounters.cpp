@@ -0,0 +1,95 @@
+#include "PerfCounters.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace DFHack;
+
+size_t LatencyHistogram::getBucketIndex(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    size_t idx = 0;
+    while (us && idx < NUM_BUCKETS - 1) {
+        us >>= 1;
+        ++idx;
+    }
+    return idx;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    buckets[getBucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t prev = max_ns.load(std::memory_order_relaxed);
+    while (prev < ns && !max_ns.compare_exchange_weak(prev, ns, std::memory_order_relaxed))
+        ;
+}
+
+void LatencyHistogram::reset() {
+    count.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+    for (auto &bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getPercentileUs(double pct) const {
+    uint64_t total = 0;
+    uint64_t counts[NUM_BUCKETS];
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        counts[i] = getBucket(i);
+        total += counts[i];
+    }
+    if (!total)
+        return 0;
+    uint64_t target = uint64_t(total * pct / 100.0);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen > target || seen == total)
+            return uint64_t(1) << i;
+    }
+    return uint64_t(1) << (NUM_BUCKETS - 1);
+}
+
+// creation and enumeration take the lock; recording into an existing
+// histogram never does
+static std::mutex registry_mutex;
+static std::map<std::string, std::unique_ptr<LatencyHistogram>> registry;
+static std::map<std::string, std::unique_ptr<EventCounter>> counter_registry;
+
+LatencyHistogram &PerfCounters::get(const std::string &name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto &hist = registry[name];
+    if (!hist)
+        hist.reset(new LatencyHistogram());
+    return *hist;
+}
+
+void PerfCounters::forEach(const std::function<void(const std::string &, const LatencyHistogram &)> &fn) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto &[name, hist] : registry)
+        fn(name, *hist);
+}
+
+EventCounter &PerfCounters::getCounter(const std::string &name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto &counter = counter_registry[name];
+    if (!counter)
+        counter.reset(new EventCounter());
+    return *counter;
+}
+
+void PerfCounters::forEachCounter(const std::function<void(const std::string &, const EventCounter &)> &fn) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto &[name, counter] : counter_registry)
+        fn(name, *counter);
+}
+
+void PerfCounters::resetAll() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto &[_, hist] : registry)
+        hist->reset();
+    for (auto &[_, counter] : counter_registry)
+        counter->reset();
+}
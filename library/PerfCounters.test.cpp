@@ -0,0 +1,51 @@
+#include "PerfCounters.h"
+
+#include <gtest/gtest.h>
+
+using namespace DFHack;
+
+TEST(PerfCounters, bucketIndex) {
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(0), 0);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(999), 0);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(1000), 1);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(1999), 1);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(2000), 2);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(1000000), 10);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(UINT64_MAX), LatencyHistogram::NUM_BUCKETS - 1);
+}
+
+TEST(PerfCounters, recordAndReset) {
+    LatencyHistogram hist;
+    for (int i = 0; i < 99; ++i)
+        hist.record(500);
+    hist.record(5000000);
+
+    EXPECT_EQ(hist.getCount(), 100);
+    EXPECT_EQ(hist.getTotalNs(), 99 * 500 + 5000000);
+    EXPECT_EQ(hist.getMaxNs(), 5000000);
+    EXPECT_EQ(hist.getPercentileUs(50), 1);
+    EXPECT_EQ(hist.getPercentileUs(100), 8192);
+
+    hist.reset();
+    EXPECT_EQ(hist.getCount(), 0);
+    EXPECT_EQ(hist.getMaxNs(), 0);
+    EXPECT_EQ(hist.getPercentileUs(50), 0);
+}
+
+TEST(PerfCounters, registry) {
+    LatencyHistogram &a = PerfCounters::get("test/a");
+    a.record(1000);
+    EXPECT_EQ(&a, &PerfCounters::get("test/a"));
+
+    size_t seen = 0;
+    PerfCounters::forEach([&](const std::string &name, const LatencyHistogram &hist) {
+        if (name == "test/a") {
+            ++seen;
+            EXPECT_EQ(hist.getCount(), 1);
+        }
+    });
+    EXPECT_EQ(seen, 1);
+
+    PerfCounters::resetAll();
+    EXPECT_EQ(a.getCount(), 0);
+}
@@ -37,6 +37,7 @@ distribution.
 
 #include "DataDefs.h"
 #include "MiscUtils.h"
+#include "PerfCounters.h"
 #include "DFHackVersion.h"
 
 #include "LuaWrapper.h"
@@ -195,6 +196,7 @@ Plugin::Plugin(Core * core, const std::string & path,
     plugin_save_site_data = 0;
     plugin_load_world_data = 0;
     plugin_load_site_data = 0;
+    update_latency = 0;
     state = PS_UNLOADED;
     access = new RefLock();
 }
@@ -550,6 +552,9 @@ command_result Plugin::on_update(color_ostream &out)
     access->lock_add();
     if(state == PS_LOADED && plugin_onupdate)
     {
+        if (!update_latency)
+            update_latency = &PerfCounters::get("update/plugins/" + name);
+        PerfTimer timer(*update_latency);
         cr = plugin_onupdate(out);
         Lua::Core::Reset(out, "plugin_onupdate");
     }
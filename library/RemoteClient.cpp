@@ -57,6 +57,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "json/json.h"
 
+#include <zlib.h>
+
 using namespace DFHack;
 
 using dfproto::CoreTextNotification;
@@ -90,6 +92,7 @@ RemoteClient::RemoteClient(color_ostream *default_output)
     : p_default_output(default_output)
 {
     active = false;
+    compression = false;
     socket = new CActiveSocket();
     suspend_ready = false;
 
@@ -188,7 +191,7 @@ bool RemoteClient::connect(int port)
 
     RPCHandshakeHeader header;
     memcpy(header.magic, RPCHandshakeHeader::REQUEST_MAGIC, sizeof(header.magic));
-    header.version = 1;
+    header.version = RPCHandshakeHeader::COMPRESSION_VERSION;
 
     if (socket->Send((uint8*)&header, sizeof(header)) != sizeof(header))
     {
@@ -205,13 +208,15 @@ bool RemoteClient::connect(int port)
     }
 
     if (memcmp(header.magic, RPCHandshakeHeader::RESPONSE_MAGIC, sizeof(header.magic)) ||
-        header.version != 1)
+        header.version < 1 || header.version > RPCHandshakeHeader::MAX_VERSION)
     {
         default_output().printerr("Invalid handshake response.\n");
         socket->Close();
         return active = false;
     }
 
+    compression = (header.version == RPCHandshakeHeader::COMPRESSION_VERSION);
+
     bind_call.name = "BindMethod";
     bind_call.p_client = this;
     bind_call.id = 0;
@@ -347,9 +352,45 @@ bool RemoteFunctionBase::bind(color_ostream &out, RemoteClient *client,
     return client->bind(out, this, name, plugin);
 }
 
-bool sendRemoteMessage(CSimpleSocket *socket, int16_t id, const MessageLite *msg, bool size_ready)
+static bool sendCompressedMessage(CSimpleSocket *socket, int16_t id, const MessageLite *msg, int size)
+{
+    std::unique_ptr<uint8_t[]> raw(new uint8_t[size]);
+    uint8_t *pend = msg->SerializeWithCachedSizesToArray(raw.get());
+    assert((pend - raw.get()) == size); (void)pend;
+
+    uLongf zsize = compressBound(size);
+    int fullsz = sizeof(RPCMessageHeader) + sizeof(int32_t) + zsize;
+    std::unique_ptr<uint8_t[]> data(new uint8_t[fullsz]);
+    uint8_t *pstart = data.get() + sizeof(RPCMessageHeader) + sizeof(int32_t);
+
+    if (compress2(pstart, &zsize, raw.get(), size, Z_BEST_SPEED) != Z_OK ||
+        zsize + sizeof(int32_t) >= uLongf(size))
+    {
+        // not worth it; send the serialized bytes as they are
+        RPCMessageHeader hdr;
+        hdr.id = id;
+        hdr.size = size;
+        return socket->Send((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+               socket->Send(raw.get(), size) == size;
+    }
+
+    int32_t raw_size = size;
+    RPCMessageHeader *hdr = (RPCMessageHeader*)data.get();
+    hdr->id = id;
+    hdr->size = int32_t(sizeof(int32_t) + zsize) | RPCMessageHeader::COMPRESSED_FLAG;
+    memcpy(data.get() + sizeof(RPCMessageHeader), &raw_size, sizeof(raw_size));
+
+    fullsz = sizeof(RPCMessageHeader) + sizeof(int32_t) + zsize;
+    return socket->Send(data.get(), fullsz) == fullsz;
+}
+
+bool sendRemoteMessage(CSimpleSocket *socket, int16_t id, const MessageLite *msg, bool size_ready, bool allow_compression)
 {
     int size = size_ready ? msg->GetCachedSize() : msg->ByteSize();
+
+    if (allow_compression && size >= RPCMessageHeader::COMPRESSION_THRESHOLD)
+        return sendCompressedMessage(socket, id, msg, size);
+
     int fullsz = size + sizeof(RPCMessageHeader);
 
     uint8_t *data = new uint8_t[fullsz];
@@ -367,6 +408,42 @@ bool sendRemoteMessage(CSimpleSocket *socket, int16_t id, const MessageLite *msg
     return (got == fullsz);
 }
 
+bool readMessageBody(CSimpleSocket *socket, RPCMessageHeader &header, std::unique_ptr<uint8_t[]> &buf, bool allow_compression)
+{
+    bool compressed = (header.size & RPCMessageHeader::COMPRESSED_FLAG) != 0;
+    int size = header.size & ~RPCMessageHeader::COMPRESSED_FLAG;
+
+    // a compressed body on a connection that never negotiated it is a protocol error
+    if (compressed && !allow_compression)
+        return false;
+
+    buf.reset(new uint8_t[size]);
+    if (!readFullBuffer(socket, buf.get(), size))
+        return false;
+
+    if (compressed)
+    {
+        int32_t raw_size;
+        if (size < (int)sizeof(raw_size))
+            return false;
+        memcpy(&raw_size, buf.get(), sizeof(raw_size));
+        if (raw_size < 0 || raw_size > RPCMessageHeader::MAX_MESSAGE_SIZE)
+            return false;
+
+        std::unique_ptr<uint8_t[]> raw(new uint8_t[raw_size]);
+        uLongf raw_len = raw_size;
+        if (uncompress(raw.get(), &raw_len, buf.get() + sizeof(raw_size), size - sizeof(raw_size)) != Z_OK ||
+            raw_len != uLongf(raw_size))
+            return false;
+
+        buf = std::move(raw);
+        size = raw_size;
+    }
+
+    header.size = size;
+    return true;
+}
+
 command_result RemoteFunctionBase::execute(color_ostream &out,
                                            const message_type *input, message_type *output)
 {
@@ -393,7 +470,7 @@ command_result RemoteFunctionBase::execute(color_ostream &out,
         return CR_LINK_FAILURE;
     }
 
-    if (!sendRemoteMessage(p_client->socket, id, input, true))
+    if (!sendRemoteMessage(p_client->socket, id, input, true, p_client->compression))
     {
         out.printerr("In call to %s::%s: I/O error in send.\n",
                      this->plugin.c_str(), this->name.c_str());
@@ -420,38 +497,44 @@ command_result RemoteFunctionBase::execute(color_ostream &out,
         if ((DFHack::DFHackReplyCode)header.id == RPC_REPLY_FAIL)
             return header.size == CR_OK ? CR_FAILURE : command_result(header.size);
 
-        if (header.size < 0 || header.size > RPCMessageHeader::MAX_MESSAGE_SIZE)
+        int body_size = header.size & ~RPCMessageHeader::COMPRESSED_FLAG;
+        if (body_size < 0 || body_size > RPCMessageHeader::MAX_MESSAGE_SIZE)
         {
             out.printerr("In call to %s::%s: invalid received size %d.\n",
-                         this->plugin.c_str(), this->name.c_str(), header.size);
+                         this->plugin.c_str(), this->name.c_str(), body_size);
+            return CR_LINK_FAILURE;
+        }
+
+        if ((header.size & RPCMessageHeader::COMPRESSED_FLAG) && !p_client->compression)
+        {
+            out.printerr("In call to %s::%s: received a compressed message, but compression was not negotiated.\n",
+                         this->plugin.c_str(), this->name.c_str());
             return CR_LINK_FAILURE;
         }
 
-        uint8_t *buf = new uint8_t[header.size];
+        std::unique_ptr<uint8_t[]> buf;
 
-        if (!readFullBuffer(p_client->socket, buf, header.size))
+        if (!readMessageBody(p_client->socket, header, buf, p_client->compression))
         {
             out.printerr("In call to %s::%s: I/O error in receive %d bytes of data.\n",
-                         this->plugin.c_str(), this->name.c_str(), header.size);
+                         this->plugin.c_str(), this->name.c_str(), body_size);
             return CR_LINK_FAILURE;
         }
 
         switch (header.id) {
         case RPC_REPLY_RESULT:
-            if (!output->ParseFromArray(buf, header.size))
+            if (!output->ParseFromArray(buf.get(), header.size))
             {
                 out.printerr("In call to %s::%s: error parsing received result.\n",
                              this->plugin.c_str(), this->name.c_str());
-                delete[] buf;
                 return CR_LINK_FAILURE;
             }
 
-            delete[] buf;
             return CR_OK;
 
         case RPC_REPLY_TEXT:
             text_data.Clear();
-            if (text_data.ParseFromArray(buf, header.size))
+            if (text_data.ParseFromArray(buf.get(), header.size))
                 text_decoder.decode(&text_data);
             else
                 out.printerr("In call to %s::%s: received invalid text data.\n",
@@ -461,6 +544,5 @@ command_result RemoteFunctionBase::execute(color_ostream &out,
         default:
             break;
         }
-        delete[] buf;
     }
 }
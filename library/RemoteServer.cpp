@@ -71,7 +71,10 @@ using google::protobuf::MessageLite;
 
 bool readFullBuffer(CSimpleSocket *socket, void *buf, int size);
 bool sendRemoteMessage(CSimpleSocket *socket, int16_t id,
-                        const ::google::protobuf::MessageLite *msg, bool size_ready);
+                        const ::google::protobuf::MessageLite *msg, bool size_ready,
+                        bool allow_compression = false);
+bool readMessageBody(CSimpleSocket *socket, RPCMessageHeader &header, std::unique_ptr<uint8_t[]> &buf,
+                     bool allow_compression);
 
 std::mutex ServerMain::access_{};
 bool ServerMain::blocked_{};
@@ -157,6 +160,7 @@ ServerConnection::ServerConnection(CActiveSocket *socket)
     : socket(socket), stream(this)
 {
     in_error = false;
+    compression = false;
 
     core_service = new CoreService();
     core_service->finalize(this, &functions);
@@ -271,7 +275,10 @@ void ServerConnection::threadFn()
         }
 
         memcpy(header.magic, RPCHandshakeHeader::RESPONSE_MAGIC, sizeof(header.magic));
-        header.version = 1;
+        // compression is opt-in: only a client asking for exactly version 2
+        // gets it, everyone else sees the version 1 reply they always have
+        compression = (header.version == RPCHandshakeHeader::COMPRESSION_VERSION);
+        header.version = compression ? RPCHandshakeHeader::COMPRESSION_VERSION : 1;
 
         if (socket->Send((uint8*)&header, sizeof(header)) != sizeof(header))
         {
@@ -297,17 +304,24 @@ void ServerConnection::threadFn()
         if ((DFHack::DFHackReplyCode)header.id == RPC_REQUEST_QUIT)
             break;
 
-        if (header.size < 0 || header.size > RPCMessageHeader::MAX_MESSAGE_SIZE)
+        int body_size = header.size & ~RPCMessageHeader::COMPRESSED_FLAG;
+        if (body_size < 0 || body_size > RPCMessageHeader::MAX_MESSAGE_SIZE)
         {
-            out.printerr("In RPC server: invalid received size %d.\n", header.size);
+            out.printerr("In RPC server: invalid received size %d.\n", body_size);
             break;
         }
 
-        std::unique_ptr<uint8_t[]> buf(new uint8_t[header.size]);
+        if ((header.size & RPCMessageHeader::COMPRESSED_FLAG) && !compression)
+        {
+            out.printerr("In RPC server: received a compressed message, but compression was not negotiated.\n");
+            break;
+        }
+
+        std::unique_ptr<uint8_t[]> buf;
 
-        if (!readFullBuffer(socket, buf.get(), header.size))
+        if (!readMessageBody(socket, header, buf, compression))
         {
-            out.printerr("In RPC server: I/O error in receive %d bytes of data.\n", header.size);
+            out.printerr("In RPC server: I/O error in receive %d bytes of data.\n", body_size);
             break;
         }
 
@@ -345,6 +359,11 @@ void ServerConnection::threadFn()
                 {
                     res = fn->execute(stream);
                 }
+                else if ((fn->flags & SF_IMMUTABLE_DATA) && Core::getInstance().beginImmutableRead())
+                {
+                    res = fn->execute(stream);
+                    Core::getInstance().endImmutableRead();
+                }
                 else
                 {
                     CoreSuspender suspend;
@@ -373,7 +392,7 @@ void ServerConnection::threadFn()
 
         if (res == CR_OK && reply)
         {
-            if (!sendRemoteMessage(socket, RPC_REPLY_RESULT, reply, true))
+            if (!sendRemoteMessage(socket, RPC_REPLY_RESULT, reply, true, compression))
             {
                 out.printerr("In RPC server: I/O error in send result.\n");
                 break;
@@ -182,6 +182,19 @@ namespace DFHack
 
         static df::viewscreen *getTopViewscreen();
 
+        // bumped once per onUpdate, so caches can tell updates apart even
+        // while the game is paused
+        uint32_t getUpdateCount() { return update_count; }
+
+        // Lets a thread read data that doesn't change while a world is loaded
+        // (raws, world generation data) without suspending the core. Returns
+        // false if no world is loaded, or one is being generated, updated,
+        // loaded, or saved. Until
+        // the matching endImmutableRead, DF is held back from unloading the
+        // world, so the reader must not try to suspend the core itself.
+        bool beginImmutableRead();
+        void endImmutableRead();
+
         DFHack::Console &getConsole() { return con; }
 
         std::unique_ptr<DFHack::Process> p;
@@ -213,6 +226,7 @@ namespace DFHack
 
         void doUpdate(color_ostream &out);
         void onUpdate(color_ostream &out);
+        void setImmutableDataValid(bool valid);
         void onStateChange(color_ostream &out, state_change_event event);
         void handleLoadAndUnloadScripts(color_ostream &out, state_change_event event);
 
@@ -271,6 +285,7 @@ namespace DFHack
         void *last_world_data_ptr;
         // for state change tracking
         void *last_local_map_ptr;
+        uint32_t update_count;
         friend struct Screen::Hide;
         df::viewscreen *top_viewscreen;
         bool last_pause_state;
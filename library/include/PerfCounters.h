@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Export.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace DFHack {
+
+/**
+ * Latency histogram with power-of-two microsecond buckets. Samples are
+ * recorded with relaxed atomic operations, so the histogram can be read or
+ * reset from another thread without ever blocking the thread that records.
+ */
+class DFHACK_EXPORT LatencyHistogram {
+public:
+    // bucket 0 counts samples under 1us, bucket i counts samples in
+    // [2^(i-1), 2^i) us, and the last bucket is open-ended
+    static const size_t NUM_BUCKETS = 24;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint64_t getTotalNs() const { return total_ns.load(std::memory_order_relaxed); }
+    uint64_t getMaxNs() const { return max_ns.load(std::memory_order_relaxed); }
+    uint64_t getBucket(size_t idx) const { return buckets[idx].load(std::memory_order_relaxed); }
+
+    // upper bound, in microseconds, of the bucket that holds the given
+    // percentile (0-100) of the recorded samples
+    uint64_t getPercentileUs(double pct) const;
+
+    static size_t getBucketIndex(uint64_t ns);
+
+private:
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> buckets[NUM_BUCKETS];
+};
+
+/**
+ * Plain event counter, for hit/miss rates of caches and indices that are too
+ * cheap to time individually.
+ */
+class DFHACK_EXPORT EventCounter {
+public:
+    EventCounter() : count(0) {}
+
+    void add(uint64_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    void reset() { count.store(0, std::memory_order_relaxed); }
+    uint64_t get() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> count;
+};
+
+/**
+ * Named registry of latency histograms used to instrument per-frame work
+ * (EventManager scans and handlers, plugin_onupdate, Lua timers), and of
+ * event counters. Neither is ever destroyed, so callers can cache the
+ * returned reference.
+ */
+namespace PerfCounters {
+    DFHACK_EXPORT LatencyHistogram &get(const std::string &name);
+    DFHACK_EXPORT void forEach(const std::function<void(const std::string &, const LatencyHistogram &)> &fn);
+    DFHACK_EXPORT EventCounter &getCounter(const std::string &name);
+    DFHACK_EXPORT void forEachCounter(const std::function<void(const std::string &, const EventCounter &)> &fn);
+    DFHACK_EXPORT void resetAll();
+}
+
+/**
+ * Records the time between its construction and destruction.
+ */
+class PerfTimer {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit PerfTimer(LatencyHistogram &hist) : hist(hist), start(clock::now()) {}
+    ~PerfTimer() {
+        hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+
+private:
+    LatencyHistogram &hist;
+    clock::time_point start;
+};
+
+}
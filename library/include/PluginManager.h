@@ -49,6 +49,7 @@ namespace DFHack
     class virtual_identity;
     class RPCService;
     class function_identity_base;
+    class LatencyHistogram;
     namespace Lua {
         class Notification;
     }
@@ -225,6 +226,9 @@ namespace DFHack
         void index_lua(DFLibrary *lib);
         void reset_lua();
 
+        // time spent in plugin_onupdate; looked up on first use
+        LatencyHistogram *update_latency;
+
         bool *plugin_is_enabled;
         std::vector<std::string>* plugin_globals;
         command_result (*plugin_init)(color_ostream &, std::vector <PluginCommand> &);
@@ -48,6 +48,10 @@ namespace  DFHack
     };
 
     struct RPCHandshakeHeader {
+        // requesting exactly this version opts in to compressed message bodies
+        static const int COMPRESSION_VERSION = 2;
+        static const int MAX_VERSION = 2;
+
         char magic[8];
         int version;
 
@@ -58,6 +62,11 @@ namespace  DFHack
     struct RPCMessageHeader {
         static const int MAX_MESSAGE_SIZE = 64*1048576;
 
+        // set in size when the body is compressed; see protocol description
+        static const int32_t COMPRESSED_FLAG = 0x40000000;
+        // bodies smaller than this are never compressed
+        static const int COMPRESSION_THRESHOLD = 16*1024;
+
         int16_t id;
         int32_t size;
     };
@@ -68,7 +77,8 @@ namespace  DFHack
      *
      *   Client initiates connection by sending the handshake
      *   request header. The server responds with the response
-     *   magic. Currently both versions must be 1.
+     *   magic and version 2 if the client requested exactly
+     *   version 2, or version 1 otherwise.
      *
      * 2. Interaction
      *
@@ -80,6 +90,15 @@ namespace  DFHack
      *   NOTE: As a special exception, RPC_REPLY_FAIL uses the size
      *         field to hold the error code directly.
      *
+     *   With protocol version 2, requests and RPC_REPLY_RESULT
+     *   messages whose body is at least COMPRESSION_THRESHOLD bytes
+     *   long may be compressed; RPC_REPLY_TEXT never is. Such
+     *   messages have COMPRESSED_FLAG set in the size field, and the
+     *   body is the uncompressed size as int32 followed by a zlib
+     *   stream. The size limit applies to both sizes. A flagged
+     *   message on a connection that did not negotiate version 2
+     *   is a protocol error and drops the connection.
+     *
      *   Every callable function is assigned a non-negative id by
      *   the server. Id 0 is reserved for BindMethod, which can be
      *   used to request any other id by function name. Id 1 is
@@ -244,6 +263,7 @@ namespace  DFHack
 
     private:
         bool active, delete_output;
+        bool compression;
         CActiveSocket *socket;
         color_ostream *p_default_output;
 
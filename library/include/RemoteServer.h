@@ -51,7 +51,13 @@ namespace  DFHack
         SF_DONT_SUSPEND = 2,
         // The function is considered safe to call from a remote computer.
         // All other functions cannot be allowed for security reasons.
-        SF_ALLOW_REMOTE = 4
+        SF_ALLOW_REMOTE = 4,
+        // The function only reads data that doesn't change while a world
+        // is loaded, like raws, so it runs without suspending the core and
+        // doesn't stall the game. Falls back to suspending the core when no
+        // world is fully loaded, e.g. during world generation. See
+        // Core::beginImmutableRead.
+        SF_IMMUTABLE_DATA = 8
     };
 
     class DFHACK_EXPORT ServerFunctionBase : public RPCFunctionBase {
@@ -227,6 +233,7 @@ namespace  DFHack
         };
 
         bool in_error;
+        bool compression;
         CActiveSocket *socket;
         connection_ostream stream;
 
@@ -123,6 +123,11 @@ DFHACK_EXPORT df::building *findAtTile(df::coord pos);
  */
 DFHACK_EXPORT bool findCivzonesAt(std::vector<df::building_civzonest*> *pvec, df::coord pos);
 
+/**
+ * Find civzones with at least one tile in the box between the two corners.
+ */
+DFHACK_EXPORT bool findCivzonesIn(std::vector<df::building_civzonest*> *pvec, df::coord pos1, df::coord pos2);
+
 /**
  * Allocates a building object using this type and position.
  */
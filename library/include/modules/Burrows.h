@@ -27,6 +27,10 @@ distribution.
 #include "DataDefs.h"
 #include "modules/Maps.h"
 
+#include "df/tile_designation.h"
+
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 /**
@@ -74,5 +78,49 @@ namespace Burrows
     inline bool deleteBlockMask(df::burrow *burrow, df::map_block *block) {
         return deleteBlockMask(burrow, block, getBlockMask(burrow, block));
     }
+
+    // Block -> mask map for one burrow, built with a single pass over the
+    // burrow's blocks so that later lookups don't walk each block's burrow
+    // list. It assumes nothing else edits the burrow's tiles while it is
+    // alive. Emptied masks are unlinked right away, but the burrow's block
+    // list is only compacted once, by flush() or the destructor.
+    class DFHACK_EXPORT BlockMaskCache {
+    public:
+        explicit BlockMaskCache(df::burrow *burrow);
+        ~BlockMaskCache() { flush(); }
+
+        BlockMaskCache(const BlockMaskCache &) = delete;
+        BlockMaskCache &operator=(const BlockMaskCache &) = delete;
+
+        df::burrow *getBurrow() const { return burrow; }
+        const std::unordered_map<df::map_block *, df::block_burrow *> &getMasks() const { return masks; }
+
+        df::block_burrow *get(df::map_block *block, bool create = false);
+        // deletes the block's mask if it has no tiles left
+        void prune(df::map_block *block);
+
+        bool isAssignedTile(df::coord tile);
+        bool setAssignedTile(df::coord tile, bool enable);
+
+        void flush();
+
+    private:
+        df::burrow *burrow;
+        std::unordered_map<df::map_block *, df::block_burrow *> masks;
+        std::unordered_set<df::map_block *> removed;
+    };
+
+    // Tile set algebra, a 16x16 block mask at a time. The target is
+    // modified in place.
+    DFHACK_EXPORT void unionTiles(df::burrow *target, df::burrow *source);
+    DFHACK_EXPORT void intersectTiles(df::burrow *target, df::burrow *source);
+    DFHACK_EXPORT void subtractTiles(df::burrow *target, df::burrow *source);
+
+    // Adds or removes every map tile in the box between the two corners.
+    DFHACK_EXPORT void setTilesInBox(df::burrow *burrow, df::coord pos1, df::coord pos2, bool enable);
+    // Adds or removes every map tile whose designation, masked with mask,
+    // equals value.
+    DFHACK_EXPORT void setTilesByDesignation(df::burrow *burrow, df::tile_designation mask,
+                                             df::tile_designation value, bool enable);
 }
 }
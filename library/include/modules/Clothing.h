@@ -0,0 +1,95 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#pragma once
+#include "Export.h"
+#include "DataDefs.h"
+
+#include "df/item_type.h"
+
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+/**
+ * \defgroup grp_clothing Clothing census shared by the clothing managers
+ * @ingroup grp_modules
+ */
+
+namespace DFHack
+{
+namespace Clothing
+{
+    // One clothing "slot": an item type and subtype made by (or owned by) a
+    // given race. material_mask has a bit set for every job_material_category
+    // bit the item's material matches, so an order for category `cat` covers
+    // the slot iff (material_mask & cat.whole) != 0.
+    struct SlotKey {
+        df::item_type type;
+        int16_t subtype;
+        int32_t race;
+        uint32_t material_mask;
+        bool clothing; // item->isClothing(), i.e. not hard armor
+
+        bool operator<(const SlotKey &other) const {
+            return std::tie(type, subtype, race, material_mask, clothing) <
+                std::tie(other.type, other.subtype, other.race, other.material_mask, other.clothing);
+        }
+
+        bool matches(df::item_type t, int16_t st, uint32_t category_mask) const {
+            return type == t && subtype == st && (material_mask & category_mask);
+        }
+    };
+
+    struct SlotCounts {
+        int32_t good = 0;      // wear level 0
+        int32_t available = 0; // good, and not forbidden, dumped, hauled off, etc.
+        int32_t tattered = 0;  // wear level 1 or more
+    };
+
+    struct Ledger {
+        int32_t frame = -1;
+        // unowned items, keyed by maker race
+        std::map<SlotKey, SlotCounts> unowned;
+        // owned items, keyed by owner race; `available` is not tracked
+        std::map<SlotKey, SlotCounts> owned;
+        // good (untattered) owned items per owner unit id
+        std::unordered_map<int32_t, std::map<SlotKey, int32_t>> owned_by_unit;
+    };
+
+    // Item flags (as df::item_flags::whole) that keep an existing item from
+    // being handed out by the clothing managers, e.g. forbidden, dumped, or
+    // owned. Items with any of these set are not counted as available.
+    DFHACK_EXPORT uint32_t getUnavailableFlags();
+
+    // Returns the census of all armor, shoes, helms, gloves, and pants in the
+    // world. It is built in a single pass over the per-type item vectors and
+    // reused until the game advances a tick, so consumers running in the same
+    // tick share one scan.
+    DFHACK_EXPORT const Ledger &getLedger();
+    // Drops the cached census; the next getLedger() call rebuilds it.
+    DFHACK_EXPORT void invalidate();
+}
+}
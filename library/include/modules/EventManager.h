@@ -15,6 +15,8 @@
 #include "df/unit_wound.h"
 #include "df/construction.h"
 
+#include <map>
+
 namespace DFHack {
     namespace EventManager {
         namespace EventType {
@@ -58,6 +60,9 @@ namespace DFHack {
             }
         };
 
+        // identifies a single callback scheduled with scheduleTick; 0 is never a valid handle
+        typedef uint64_t TickHandle;
+
         struct SyndromeData {
             int32_t unitId;
             int32_t syndromeIndex;
@@ -119,6 +124,12 @@ namespace DFHack {
 
         DFHACK_EXPORT void registerListener(EventType::EventType e, EventHandler handler, Plugin* plugin);
         DFHACK_EXPORT int32_t registerTick(EventHandler handler, int32_t when, Plugin* plugin, bool absolute=false);
+        // like registerTick, but returns a handle that can be passed to cancelTick
+        DFHACK_EXPORT TickHandle scheduleTick(EventHandler handler, int32_t when, Plugin* plugin, bool absolute=false);
+        DFHACK_EXPORT bool cancelTick(TickHandle handle);
+        // number of pending TICK callbacks, in total and per plugin
+        DFHACK_EXPORT size_t getTickQueueDepth();
+        DFHACK_EXPORT std::map<Plugin*, size_t> getTickCountsByPlugin();
         DFHACK_EXPORT void unregister(EventType::EventType e, EventHandler handler, Plugin* plugin);
         DFHACK_EXPORT void unregisterAll(Plugin* plugin);
         void manageEvents(color_ostream& out);
@@ -39,6 +39,7 @@ distribution.
 #include "df/inclusion_type.h"
 
 #include <bitset>
+#include <memory>
 
 namespace df {
     struct world_region_details;
@@ -612,15 +613,7 @@ class DFHACK_EXPORT MapCache
 
     bool WriteAll();
 
-    void trash()
-    {
-        std::map<DFCoord, Block *>::iterator p;
-        for(p = blocks.begin(); p != blocks.end(); p++)
-        {
-            delete p->second;
-        }
-        blocks.clear();
-    }
+    void trash();
 
     uint32_t maxBlockX() { return x_bmax; }
     uint32_t maxBlockY() { return y_bmax; }
@@ -647,8 +640,23 @@ private:
     uint32_t y_tmax;
     uint32_t z_max;
     std::vector<BiomeInfo> biomes;
-    std::map<df::coord2d, df::world_region_details*> region_details;
-    std::map<DFCoord, Block *> blocks;
+
+    // Blocks are found through one row-major page of pointers per z-level,
+    // allocated on first touch, and are constructed in pooled storage so
+    // full-map passes neither walk a tree nor hit the heap per block.
+    struct alignas(Block) BlockStorage {
+        unsigned char bytes[sizeof(Block)];
+    };
+    static constexpr size_t BLOCK_POOL_CHUNK = 64;
+
+    std::vector<std::unique_ptr<Block *[]>> block_levels;
+    std::vector<std::unique_ptr<BlockStorage[]>> block_pool;
+    std::vector<BlockStorage *> free_blocks;
+
+    Block *findBlock(DFCoord blockcoord);
+    Block *newBlock(DFCoord blockcoord);
+    void deleteBlock(Block *block);
+    template<typename F> void forEachBlock(F fn);
 };
 }
 #endif
@@ -32,6 +32,7 @@ distribution.
 
 #include "Export.h"
 #include "Module.h"
+#include <functional>
 #include <vector>
 #include "BitArray.h"
 #include "modules/Materials.h"
@@ -284,6 +285,43 @@ namespace DFHack
 
         extern DFHACK_EXPORT df::map_block_column * getBlockColumn(int32_t blockx, int32_t blocky);
 
+        /**
+         * Call fn for every allocated map block, spreading the blocks across
+         * a set of worker threads. The core must stay suspended for the whole
+         * call, and fn must only read game state: no writes to DF memory, no
+         * Lua, no console output, and no DFHack APIs that lock or cache. The
+         * calling thread takes part as worker 0, and worker is always below
+         * getParallelWorkerCount(), so callers can keep per-worker state and
+         * merge it once the call returns. The first exception thrown by fn is
+         * rethrown on the calling thread after all workers have stopped.
+         */
+        extern DFHACK_EXPORT void parallelForEachBlock(const std::function<void(df::map_block *block, size_t worker)> &fn);
+        extern DFHACK_EXPORT size_t getParallelWorkerCount();
+
+        /**
+         * Designation census: counts of pending designations per map block and
+         * for the whole fortress. The census is rebuilt from the blocks DF has
+         * flagged as designated at most once per Core update (which keeps
+         * running while the game is paused); further queries in the same
+         * update return the cached totals. DFHack's own designation setters
+         * call invalidateDesignationCensus so that their changes show up
+         * within the same update.
+         */
+        struct DesignationCounts {
+            int32_t dig = 0;    // dig, channel, ramp, and stair designations
+            int32_t marked = 0; // dig designations in marker mode
+            int32_t smooth = 0; // smooth and engrave designations
+            int32_t track = 0;  // carve track designations
+
+            int32_t total() const { return dig + marked + smooth + track; }
+        };
+        extern DFHACK_EXPORT const DesignationCounts &getDesignationCounts();
+        /// call fn for every block with at least one designation, in no particular order
+        extern DFHACK_EXPORT void forEachDesignatedBlock(const std::function<void(df::map_block *block, const DesignationCounts &counts)> &fn);
+        /// recount block on the next census query, even within the same update
+        extern DFHACK_EXPORT void invalidateDesignationCensus(df::map_block *block);
+        extern DFHACK_EXPORT void resetDesignationCensus();
+
         inline df::map_block * getBlock (df::coord pos) { return getBlock(pos.x, pos.y, pos.z); }
         inline df::map_block * getTileBlock (df::coord pos) { return getTileBlock(pos.x, pos.y, pos.z); }
         inline df::map_block * ensureTileBlock (df::coord pos) { return ensureTileBlock(pos.x, pos.y, pos.z); }
@@ -0,0 +1,81 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#pragma once
+#include "Export.h"
+#include "DataDefs.h"
+
+#include "df/item_type.h"
+#include "df/job_type.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * \defgroup grp_orders Manager order lookup
+ * @ingroup grp_modules
+ */
+
+namespace df
+{
+    struct manager_order;
+}
+
+namespace DFHack
+{
+namespace Orders
+{
+    // The fields that identify what a manager order produces. Fields left at
+    // their defaults only match orders that also leave them unset.
+    struct OrderSpec {
+        df::job_type job_type = df::job_type::NONE;
+        df::item_type item_type = df::item_type::NONE;
+        int16_t item_subtype = -1;
+        int16_t mat_type = -1;
+        int32_t mat_index = -1;
+        uint32_t material_category = 0;
+        int32_t hist_figure_id = -1;
+
+        bool matches(const df::manager_order *order) const;
+    };
+
+    // Live orders with the given job type and item subtype, in the order they
+    // appear in world->manager_orders. The index behind this is rebuilt only
+    // when the sequence of orders or manager_order_next_id has changed. A
+    // lookup checks the list size and next id; the full sequence is compared
+    // at most once per Core update, so repeated lookups are O(1).
+    DFHACK_EXPORT const std::vector<df::manager_order *> &getOrders(df::job_type job_type, int16_t item_subtype = -1);
+
+    // First order that matches every field of spec, or NULL.
+    DFHACK_EXPORT df::manager_order *findOrder(const OrderSpec &spec);
+    // Sum of amount_left over all orders that match spec.
+    DFHACK_EXPORT int32_t getAmountLeft(const OrderSpec &spec);
+
+    // Appends the order to world->manager_orders, assigning the next order id
+    // if it doesn't have one, and keeps the index current.
+    DFHACK_EXPORT void addOrder(df::manager_order *order);
+
+    DFHACK_EXPORT void invalidate();
+}
+}
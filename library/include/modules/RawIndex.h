@@ -0,0 +1,58 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#pragma once
+#include "Export.h"
+#include "DataDefs.h"
+
+#include "df/item_type.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * \defgroup grp_rawindex Raw token lookup
+ * @ingroup grp_modules
+ */
+
+namespace DFHack
+{
+namespace RawIndex
+{
+    // Index of the raw with the given id in world->raws, or -1. Each table is
+    // hashed on first use and rebuilt only when the raw vector it was built
+    // from has been resized or reallocated, so lookups are O(1) instead of a
+    // scan with a string compare per raw.
+    DFHACK_EXPORT int32_t findInorganic(const std::string &id);
+    DFHACK_EXPORT int32_t findPlant(const std::string &id);
+    DFHACK_EXPORT int32_t findCreature(const std::string &id);
+
+    // Subtype of the itemdef with the given id, or -1 if the item type has
+    // no subtypes or none with that id.
+    DFHACK_EXPORT int16_t findItemSubtype(df::item_type type, const std::string &id);
+
+    DFHACK_EXPORT void invalidate();
+}
+}
@@ -137,8 +137,9 @@ namespace DFHack
             PenArray(unsigned int bufwidth, unsigned int bufheight, void *buf);
             ~PenArray();
             void clear();
-            unsigned int get_dimx() { return dimx; }
-            unsigned int get_dimy() { return dimy; }
+            unsigned int get_dimx() const { return dimx; }
+            unsigned int get_dimy() const { return dimy; }
+            const Pen *get_row(unsigned int y) const { return buffer + y * dimx; }
             Pen get_tile(unsigned int x, unsigned int y);
             void set_tile(unsigned int x, unsigned int y, Screen::Pen pen);
             void draw(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
@@ -201,6 +202,13 @@ namespace DFHack
         /// Paint one screen tile with the given pen
         DFHACK_EXPORT bool paintTile(const Pen &pen, int x, int y, bool map = false);
 
+        /// Paint len tiles of one row, starting at (x, y), with consecutive pens from
+        /// the array. Much cheaper than a loop over paintTile for long runs.
+        DFHACK_EXPORT bool paintSpan(const Pen *pens, int len, int x, int y, bool map = false);
+
+        /// Paint the whole pen array with its top left corner at (x, y).
+        DFHACK_EXPORT bool paintRect(const PenArray &pens, int x, int y, bool map = false);
+
         /// Retrieves one screen tile from the buffer
         DFHACK_EXPORT Pen readTile(int x, int y, bool map = false);
 
@@ -316,6 +324,7 @@ namespace DFHack
         namespace Hooks {
             GUI_HOOK_DECLARE(get_tile, Pen, (int x, int y, bool map));
             GUI_HOOK_DECLARE(set_tile, bool, (const Pen &pen, int x, int y, bool map));
+            GUI_HOOK_DECLARE(set_tile_span, bool, (const Pen *pens, int pen_step, int x, int y, int len, bool map));
         }
 
         //! Temporary hide a screen until destructor is called
@@ -41,6 +41,8 @@ distribution.
 #include "df/unit_action.h"
 #include "df/unit_action_type_group.h"
 
+#include <functional>
+
 namespace df
 {
     struct activity_entry;
@@ -157,6 +159,49 @@ DFHACK_EXPORT bool getUnitsByNobleRole(std::vector<df::unit *> &units, std::stri
 DFHACK_EXPORT df::unit *getUnitByNobleRole(std::string noble);
 DFHACK_EXPORT bool getCitizens(std::vector<df::unit *> &citizens, bool ignore_sanity = false);
 
+/**
+ * A conjunction of unit filters that is evaluated cheapest first: plain
+ * field and flag tests, then raw lookups, then checks that walk refs or
+ * inventory. Race and age filters are resolved to field comparisons when
+ * they are added, so selecting from thousands of units rarely reaches an
+ * expensive check. Build one per command and reuse it for every unit.
+ */
+class DFHACK_EXPORT UnitQuery {
+public:
+    enum Cost { CHEAP, MODERATE, EXPENSIVE };
+    typedef std::function<bool(df::unit *)> Predicate;
+
+    UnitQuery &add(Predicate pred, Cost cost = EXPENSIVE, bool negate = false);
+    /// adds one of the filters listed by getFilterNames(); false if unknown
+    bool addNamed(const std::string &name, bool negate = false);
+    /// race by creature id, e.g. "DOG"; an unknown id matches no units
+    UnitQuery &race(const std::string &creature_id, bool negate = false);
+    UnitQuery &race(int32_t race_id, bool negate = false);
+    /// true age, in whole years
+    UnitQuery &age(int years, bool negate = false);
+    UnitQuery &minAge(double years, bool negate = false);
+    UnitQuery &maxAge(double years, bool negate = false);
+
+    bool empty() const { return steps.empty(); }
+    bool matches(df::unit *unit) const;
+    /// appends the units that pass every filter to out
+    void select(std::vector<df::unit *> &out, const std::vector<df::unit *> &units) const;
+
+    static bool hasFilter(const std::string &name);
+    static std::vector<std::string> getFilterNames();
+
+private:
+    struct Step {
+        Predicate pred;
+        Cost cost;
+        bool negate;
+    };
+    // kept ordered by cost; filters of equal cost keep the order they were added
+    std::vector<Step> steps;
+
+    UnitQuery &addBirthBound(double years, bool upper, bool negate);
+};
+
 DFHACK_EXPORT int32_t findIndexById(int32_t id);
 
 /// Returns the true position of the unit (non-trivial in case of caged).
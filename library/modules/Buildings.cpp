@@ -46,6 +46,7 @@ using namespace std;
 #include "Core.h"
 #include "TileTypes.h"
 #include "MiscUtils.h"
+#include "PerfCounters.h"
 using namespace DFHack;
 
 #include "DataDefs.h"
@@ -123,6 +124,10 @@ static df::building_extents_type *getExtentTile(df::building_extents &extent, df
  */
 bool buildings_do_onupdate = false;
 
+// bumped by Core::onUpdate every frame, so that caches can tell frames apart
+// even while the game is paused
+uint32_t buildings_update_count = 1;
+
 void buildings_onStateChange(color_ostream &out, state_change_event event)
 {
     switch (event) {
@@ -218,6 +223,9 @@ static void add_building_to_all_zones(df::building* bld)
         add_building_to_zone(bld, zone);
 }
 
+static void findBuildingsInBox(std::vector<df::building*> *pvec,
+                               int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t z);
+
 static void add_zone_to_all_buildings(df::building* zone_as_building)
 {
     if (zone_as_building->getType() != building_type::Civzone)
@@ -228,11 +236,11 @@ static void add_zone_to_all_buildings(df::building* zone_as_building)
     if (zone == nullptr)
         return;
 
-    for (auto bld : world->buildings.other.IN_PLAY)
-    {
-        if (zone->z != bld->z)
-            continue;
+    std::vector<df::building*> candidates;
+    findBuildingsInBox(&candidates, zone->x1, zone->y1, zone->x2, zone->y2, zone->z);
 
+    for (auto bld : candidates)
+    {
         if (!is_suitable_building_for_zoning(bld))
             continue;
 
@@ -285,7 +293,15 @@ static void remove_building_from_all_zones(df::building* bld)
         remove_building_from_zone(bld, zone);
 }
 
-static void remove_zone_from_all_buildings(df::building* zone_as_building)
+static bool getIndexedZoneBounds(df::building_civzonest *zone,
+                                 int32_t &x1, int32_t &y1, int32_t &x2, int32_t &y2, int32_t &z);
+
+// With full_sweep, the zone is unlinked from every building in play, which
+// is slow but repairs bad game states; use it when the zone is deleted, so
+// nothing is left pointing at it. Otherwise, only the zone's children and
+// the buildings under its current and last indexed extents are visited,
+// which is enough when the zone is reshaped.
+static void remove_zone_from_all_buildings(df::building* zone_as_building, bool full_sweep)
 {
     if (zone_as_building->getType() != building_type::Civzone)
         return;
@@ -295,9 +311,31 @@ static void remove_zone_from_all_buildings(df::building* zone_as_building)
     if (zone == nullptr)
         return;
 
-    //this is a paranoid check and slower than it could be. Zones contain a list of children
-    //good for fixing potentially bad game states when deleting a zone
-    for (auto bld : world->buildings.other.IN_PLAY)
+    if (full_sweep)
+    {
+        for (auto bld : world->buildings.other.IN_PLAY)
+            remove_building_from_zone(bld, zone);
+        return;
+    }
+
+    std::vector<df::building*> candidates(zone->contained_buildings.begin(),
+                                          zone->contained_buildings.end());
+
+    std::vector<df::building*> in_box;
+    findBuildingsInBox(&in_box, zone->x1, zone->y1, zone->x2, zone->y2, zone->z);
+    candidates.insert(candidates.end(), in_box.begin(), in_box.end());
+
+    int32_t x1, y1, x2, y2, z;
+    if (getIndexedZoneBounds(zone, x1, y1, x2, y2, z))
+    {
+        findBuildingsInBox(&in_box, x1, y1, x2, y2, z);
+        candidates.insert(candidates.end(), in_box.begin(), in_box.end());
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (auto bld : candidates)
         remove_building_from_zone(bld, zone);
 }
 
@@ -391,8 +429,132 @@ bool Buildings::setOwner(df::building_civzonest *bld, df::unit *unit)
     return true;
 }
 
+static unordered_map<int32_t, df::coord> corner1;
+static unordered_map<int32_t, df::coord> corner2;
+
+/*
+ * Spatial index over the bounding boxes of occupancy-setting buildings. Each
+ * cell covers one 16x16 map block on one z-level and lists the ids of the
+ * buildings that overlap it, so a lookup only ever examines the handful of
+ * buildings near the tile. Entries for destroyed buildings are tolerated
+ * because every candidate is re-validated against the live building.
+ */
+static unordered_map<df::coord, vector<int32_t>, CoordHash> buildingCells;
+
+// all buildings with ids below this have been offered to the index
+static int32_t indexedNextId = -1;
+
+static df::coord cellOf(int x, int y, int z) {
+    return df::coord(x >> 4, y >> 4, z);
+}
+
+static void indexBuilding(int32_t id, df::coord p1, df::coord p2) {
+    for (int32_t cx = p1.x >> 4; cx <= p2.x >> 4; cx++)
+        for (int32_t cy = p1.y >> 4; cy <= p2.y >> 4; cy++)
+            buildingCells[df::coord(cx, cy, p1.z)].push_back(id);
+}
+
+static void unindexBuilding(int32_t id, df::coord p1, df::coord p2) {
+    for (int32_t cx = p1.x >> 4; cx <= p2.x >> 4; cx++) {
+        for (int32_t cy = p1.y >> 4; cy <= p2.y >> 4; cy++) {
+            auto cell = buildingCells.find(df::coord(cx, cy, p1.z));
+            if (cell == buildingCells.end())
+                continue;
+            auto &ids = cell->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty())
+                buildingCells.erase(cell);
+        }
+    }
+}
+
+static void cacheBuilding(df::building *building) {
+    int32_t id = building->id;
+    df::coord p1(min(building->x1, building->x2), min(building->y1,building->y2), building->z);
+    df::coord p2(max(building->x1, building->x2), max(building->y1,building->y2), building->z);
+
+    corner1[id] = p1;
+    corner2[id] = p2;
+    indexBuilding(id, p1, p2);
+
+    for (int32_t x = p1.x; x <= p2.x; x++) {
+        for (int32_t y = p1.y; y <= p2.y; y++) {
+            df::coord pt(x, y, building->z);
+            if (Buildings::containsTile(building, pt)) {
+                locationToBuilding[pt] = id;
+            }
+        }
+    }
+}
+
+static void uncacheBuilding(int32_t id) {
+    df::coord p1 = corner1[id];
+    df::coord p2 = corner2[id];
+
+    for ( int32_t x = p1.x; x <= p2.x; x++ ) {
+        for ( int32_t y = p1.y; y <= p2.y; y++ ) {
+            df::coord pt(x,y,p1.z);
+
+            auto cur = locationToBuilding.find(pt);
+            if (cur != locationToBuilding.end() && cur->second == id)
+                locationToBuilding.erase(cur);
+        }
+    }
+
+    unindexBuilding(id, p1, p2);
+    corner1.erase(id);
+    corner2.erase(id);
+}
+
+/*
+ * Buildings get their ids from building_next_id as they are linked into the
+ * id-sorted building vector, so everything created since the last sync sits
+ * at the tail of the vector. Picking those up here keeps the index complete
+ * between the EventManager's building scans.
+ */
+static void syncBuildingIndex() {
+    if (*building_next_id == indexedNextId)
+        return;
+
+    auto &vec = df::building::get_vector();
+    auto it = std::lower_bound(vec.begin(), vec.end(), indexedNextId,
+        [](df::building *bld, int32_t id) { return bld->id < id; });
+    for (; it != vec.end(); ++it) {
+        auto bld = *it;
+        if (bld->isSettingOccupancy() && !corner1.count(bld->id))
+            cacheBuilding(bld);
+    }
+
+    indexedNextId = *building_next_id;
+}
+
+static bool isBuildingAtTile(df::building *bld, df::coord pos)
+{
+    if (pos.z != bld->z ||
+        pos.x < bld->x1 || pos.x > bld->x2 ||
+        pos.y < bld->y1 || pos.y > bld->y2)
+        return false;
+
+    if (!bld->isSettingOccupancy())
+        return false;
+
+    if (bld->room.extents && bld->isExtentShaped())
+    {
+        auto etile = getExtentTile(bld->room, pos);
+        if (!etile || !*etile)
+            return false;
+    }
+
+    return true;
+}
+
 df::building *Buildings::findAtTile(df::coord pos)
 {
+    static auto &cache_hits = PerfCounters::getCounter("buildings/findAtTile/cache");
+    static auto &index_hits = PerfCounters::getCounter("buildings/findAtTile/index");
+    static auto &index_misses = PerfCounters::getCounter("buildings/findAtTile/miss");
+    static auto &scans = PerfCounters::getCounter("buildings/findAtTile/scan");
+
     auto occ = Maps::getTileOccupancy(pos);
     if (!occ || !occ->bits.building)
         return NULL;
@@ -407,74 +569,359 @@ df::building *Buildings::findAtTile(df::coord pos)
             building->isSettingOccupancy() &&
             containsTile(building, pos))
         {
+            cache_hits.add();
             return building;
         }
     }
 
+    if (building_next_id)
+    {
+        // Stale or missing tile entry; ask the spatial index instead:
+        syncBuildingIndex();
+
+        auto cell = buildingCells.find(cellOf(pos.x, pos.y, pos.z));
+        if (cell != buildingCells.end())
+        {
+            for (int32_t id : cell->second)
+            {
+                auto bld = df::building::find(id);
+                if (bld && isBuildingAtTile(bld, pos))
+                {
+                    locationToBuilding[pos] = id;
+                    index_hits.add();
+                    return bld;
+                }
+            }
+        }
+
+        index_misses.add();
+        return NULL;
+    }
+
     // The authentic method, i.e. how the game generally does this:
+    scans.add();
     auto &vec = df::building::get_vector();
     for (size_t i = 0; i < vec.size(); i++)
     {
         auto bld = vec[i];
+        if (isBuildingAtTile(bld, pos))
+            return bld;
+    }
 
-        if (pos.z != bld->z ||
-            pos.x < bld->x1 || pos.x > bld->x2 ||
-            pos.y < bld->y1 || pos.y > bld->y2)
-            continue;
+    return NULL;
+}
 
-        if (!bld->isSettingOccupancy())
-            continue;
+// live buildings from the spatial index whose bounding boxes overlap the box
+static void findBuildingsInBox(std::vector<df::building*> *pvec,
+                               int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t z)
+{
+    pvec->clear();
 
-        if (bld->room.extents && bld->isExtentShaped())
+    if (!building_next_id)
+    {
+        for (auto bld : world->buildings.other.IN_PLAY)
         {
-            auto etile = getExtentTile(bld->room, pos);
-            if (!etile || !*etile)
+            if (bld->z == z)
+                pvec->push_back(bld);
+        }
+        return;
+    }
+
+    syncBuildingIndex();
+
+    std::vector<int32_t> ids;
+    for (int32_t cx = min(x1, x2) >> 4; cx <= max(x1, x2) >> 4; cx++)
+    {
+        for (int32_t cy = min(y1, y2) >> 4; cy <= max(y1, y2) >> 4; cy++)
+        {
+            auto cell = buildingCells.find(df::coord(cx, cy, z));
+            if (cell != buildingCells.end())
+                ids.insert(ids.end(), cell->second.begin(), cell->second.end());
+        }
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    for (int32_t id : ids)
+    {
+        auto bld = df::building::find(id);
+        if (bld && bld->z == z)
+            pvec->push_back(bld);
+    }
+}
+
+/*
+ * Spatial index over civzone bounding boxes, on the same 16x16 cells as the
+ * building index. Each cell lists positions in ANY_ZONE, kept sorted so that
+ * lookups return zones in the same order as a scan of the vector would.
+ *
+ * Zones are created, resized, and destroyed by the game as well as by us, so
+ * the index is rebuilt whenever ANY_ZONE changes, and the bounds of every
+ * zone are rechecked once per Core update, which runs every frame whether or
+ * not the game is paused. Between updates, a lookup only examines the zones
+ * near the tile, each of which is verified against its live extents.
+ */
+namespace {
+    struct ZoneEntry {
+        df::building_civzonest *zone;
+        int32_t x1, y1, x2, y2, z;
+
+        void setBounds(df::building_civzonest *zone) {
+            x1 = min(zone->x1, zone->x2);
+            y1 = min(zone->y1, zone->y2);
+            x2 = max(zone->x1, zone->x2);
+            y2 = max(zone->y1, zone->y2);
+            z = zone->z;
+        }
+
+        bool hasBounds(df::building_civzonest *zone) const {
+            return x1 == min(zone->x1, zone->x2) && y1 == min(zone->y1, zone->y2) &&
+                x2 == max(zone->x1, zone->x2) && y2 == max(zone->y1, zone->y2) &&
+                z == zone->z;
+        }
+    };
+
+    struct ZoneFingerprint {
+        size_t size = 0;
+        df::building_civzonest * const *data = NULL;
+        df::building_civzonest *front = NULL;
+        df::building_civzonest *back = NULL;
+
+        static ZoneFingerprint of(const std::vector<df::building_civzonest*> &zones) {
+            ZoneFingerprint fp;
+            fp.size = zones.size();
+            fp.data = zones.data();
+            fp.front = zones.empty() ? NULL : zones.front();
+            fp.back = zones.empty() ? NULL : zones.back();
+            return fp;
+        }
+
+        bool operator==(const ZoneFingerprint &other) const {
+            return size == other.size && data == other.data &&
+                front == other.front && back == other.back;
+        }
+    };
+}
+
+static bool zoneIndexValid = false;
+static ZoneFingerprint zoneFingerprint;
+static uint32_t zoneCheckedUpdate = 0;
+static vector<ZoneEntry> zoneEntries;
+static unordered_map<df::building_civzonest*, size_t> zoneEntryIndex;
+static unordered_map<df::coord, vector<size_t>, CoordHash> zoneCells;
+
+static void indexZone(size_t idx)
+{
+    auto &entry = zoneEntries[idx];
+    for (int32_t cx = entry.x1 >> 4; cx <= entry.x2 >> 4; cx++)
+    {
+        for (int32_t cy = entry.y1 >> 4; cy <= entry.y2 >> 4; cy++)
+        {
+            auto &cell = zoneCells[df::coord(cx, cy, entry.z)];
+            cell.insert(std::lower_bound(cell.begin(), cell.end(), idx), idx);
+        }
+    }
+}
+
+static void unindexZone(size_t idx)
+{
+    auto &entry = zoneEntries[idx];
+    for (int32_t cx = entry.x1 >> 4; cx <= entry.x2 >> 4; cx++)
+    {
+        for (int32_t cy = entry.y1 >> 4; cy <= entry.y2 >> 4; cy++)
+        {
+            auto cell = zoneCells.find(df::coord(cx, cy, entry.z));
+            if (cell == zoneCells.end())
                 continue;
+            auto &ids = cell->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), idx), ids.end());
+            if (ids.empty())
+                zoneCells.erase(cell);
         }
+    }
+}
+
+static void reindexZone(size_t idx)
+{
+    unindexZone(idx);
+    zoneEntries[idx].setBounds(zoneEntries[idx].zone);
+    indexZone(idx);
+}
+
+static void rebuildZoneIndex()
+{
+    static auto &rebuilds = PerfCounters::getCounter("buildings/zoneIndex/rebuild");
+    rebuilds.add();
+
+    auto &zones = world->buildings.other.ANY_ZONE;
+
+    zoneEntries.clear();
+    zoneEntryIndex.clear();
+    zoneCells.clear();
 
-        return bld;
+    zoneEntries.reserve(zones.size());
+    for (size_t i = 0; i < zones.size(); i++)
+    {
+        ZoneEntry entry;
+        entry.zone = zones[i];
+        entry.setBounds(zones[i]);
+        zoneEntries.push_back(entry);
+        zoneEntryIndex[zones[i]] = i;
+        indexZone(i);
     }
 
-    return NULL;
+    zoneFingerprint = ZoneFingerprint::of(zones);
+    zoneCheckedUpdate = buildings_update_count;
+    zoneIndexValid = true;
 }
 
-static unordered_map<int32_t, df::coord> corner1;
-static unordered_map<int32_t, df::coord> corner2;
-static void cacheBuilding(df::building *building) {
-    int32_t id = building->id;
-    df::coord p1(min(building->x1, building->x2), min(building->y1,building->y2), building->z);
-    df::coord p2(max(building->x1, building->x2), max(building->y1,building->y2), building->z);
+static void refreshZoneIndex()
+{
+    static auto &moves = PerfCounters::getCounter("buildings/zoneIndex/move");
 
-    corner1[id] = p1;
-    corner2[id] = p2;
+    auto &zones = world->buildings.other.ANY_ZONE;
+    if (!zoneIndexValid || !(ZoneFingerprint::of(zones) == zoneFingerprint))
+    {
+        rebuildZoneIndex();
+        return;
+    }
 
-    for (int32_t x = p1.x; x <= p2.x; x++) {
-        for (int32_t y = p1.y; y <= p2.y; y++) {
-            df::coord pt(x, y, building->z);
-            if (Buildings::containsTile(building, pt)) {
-                locationToBuilding[pt] = id;
-            }
+    if (zoneCheckedUpdate == buildings_update_count)
+        return;
+
+    for (size_t i = 0; i < zoneEntries.size(); i++)
+    {
+        if (!zoneEntries[i].hasBounds(zoneEntries[i].zone))
+        {
+            moves.add();
+            reindexZone(i);
         }
     }
+    zoneCheckedUpdate = buildings_update_count;
+}
+
+// picks up a zone that was just linked in at the end of ANY_ZONE without
+// rebuilding the whole index
+static void addZoneToIndex(df::building_civzonest *zone)
+{
+    auto &zones = world->buildings.other.ANY_ZONE;
+    if (!zoneIndexValid)
+        return;
+
+    size_t n = zones.size();
+    if (n == 0 || zones.back() != zone || zoneFingerprint.size != n - 1 ||
+        zoneFingerprint.back != (n > 1 ? zones[n - 2] : NULL) ||
+        zoneFingerprint.front != (n > 1 ? zones.front() : NULL))
+    {
+        zoneIndexValid = false;
+        return;
+    }
+
+    ZoneEntry entry;
+    entry.zone = zone;
+    entry.setBounds(zone);
+    zoneEntries.push_back(entry);
+    zoneEntryIndex[zone] = n - 1;
+    indexZone(n - 1);
+    zoneFingerprint = ZoneFingerprint::of(zones);
+}
+
+static bool getIndexedZoneBounds(df::building_civzonest *zone,
+                                 int32_t &x1, int32_t &y1, int32_t &x2, int32_t &y2, int32_t &z)
+{
+    if (!zoneIndexValid)
+        return false;
+
+    auto it = zoneEntryIndex.find(zone);
+    if (it == zoneEntryIndex.end())
+        return false;
+
+    auto &entry = zoneEntries[it->second];
+    x1 = entry.x1; y1 = entry.y1; x2 = entry.x2; y2 = entry.y2; z = entry.z;
+    return true;
+}
+
+static bool isZoneAtTile(df::building_civzonest *zone, df::coord pos)
+{
+    if (pos.z != zone->z)
+        return false;
+
+    if (!zone->room.extents || !zone->isExtentShaped())
+        return false;
+
+    auto etile = getExtentTile(zone->room, pos);
+    return etile && *etile;
 }
 
 bool Buildings::findCivzonesAt(std::vector<df::building_civzonest*> *pvec,
                                df::coord pos) {
     pvec->clear();
 
-    for (df::building_civzonest* zone : world->buildings.other.ANY_ZONE)
+    refreshZoneIndex();
+
+    auto cell = zoneCells.find(cellOf(pos.x, pos.y, pos.z));
+    if (cell == zoneCells.end())
+        return false;
+
+    for (size_t idx : cell->second)
+    {
+        auto zone = zoneEntries[idx].zone;
+        if (isZoneAtTile(zone, pos))
+            pvec->push_back(zone);
+    }
+
+    return !pvec->empty();
+}
+
+bool Buildings::findCivzonesIn(std::vector<df::building_civzonest*> *pvec,
+                               df::coord pos1, df::coord pos2) {
+    pvec->clear();
+
+    refreshZoneIndex();
+
+    int32_t x1 = min(pos1.x, pos2.x), x2 = max(pos1.x, pos2.x);
+    int32_t y1 = min(pos1.y, pos2.y), y2 = max(pos1.y, pos2.y);
+    int32_t z1 = min(pos1.z, pos2.z), z2 = max(pos1.z, pos2.z);
+
+    std::vector<size_t> candidates;
+    for (int32_t z = z1; z <= z2; z++)
     {
-        if (pos.z != zone->z)
+        for (int32_t cx = x1 >> 4; cx <= x2 >> 4; cx++)
+        {
+            for (int32_t cy = y1 >> 4; cy <= y2 >> 4; cy++)
+            {
+                auto cell = zoneCells.find(df::coord(cx, cy, z));
+                if (cell != zoneCells.end())
+                    candidates.insert(candidates.end(), cell->second.begin(), cell->second.end());
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (size_t idx : candidates)
+    {
+        auto zone = zoneEntries[idx].zone;
+        if (!zone->room.extents || !zone->isExtentShaped())
             continue;
 
-        if (zone->room.extents && zone->isExtentShaped())
+        // any extent tile inside the overlap of the box and the zone
+        int32_t ox1 = max(x1, zone->room.x), ox2 = min(x2, zone->room.x + zone->room.width - 1);
+        int32_t oy1 = max(y1, zone->room.y), oy2 = min(y2, zone->room.y + zone->room.height - 1);
+        bool found = false;
+        for (int32_t y = oy1; y <= oy2 && !found; y++)
         {
-            auto etile = getExtentTile(zone->room, pos);
-            if (!etile || !*etile)
-                continue;
+            for (int32_t x = ox1; x <= ox2 && !found; x++)
+            {
+                auto etile = getExtentTile(zone->room, df::coord2d(x, y));
+                found = etile && *etile;
+            }
+        }
 
+        if (found)
             pvec->push_back(zone);
-        }
     }
 
     return !pvec->empty();
@@ -1158,6 +1605,9 @@ bool Buildings::constructAbstract(df::building *bld)
 
     linkBuilding(bld);
 
+    if (auto zone = strict_virtual_cast<df::building_civzonest>(bld))
+        addZoneToIndex(zone);
+
     if (!bld->flags.bits.exists)
     {
         bld->flags.bits.exists = true;
@@ -1349,7 +1799,7 @@ static void delete_assigned_unit_links(df::building_civzonest* zone)
 
 static void on_civzone_delete(df::building_civzonest* civzone)
 {
-    remove_zone_from_all_buildings(civzone);
+    remove_zone_from_all_buildings(civzone, true);
     delete_civzone_squad_links(civzone);
     delete_assigned_unit_links(civzone);
 }
@@ -1444,15 +1894,29 @@ void Buildings::notifyCivzoneModified(df::building* bld)
     if (bld->getType() != building_type::Civzone)
         return;
 
-    //remove zone here needs to be the slow method
-    remove_zone_from_all_buildings(bld);
+    // unlinks buildings under both the old and the new extents
+    remove_zone_from_all_buildings(bld, false);
     add_zone_to_all_buildings(bld);
+
+    auto zone = strict_virtual_cast<df::building_civzonest>(bld);
+    if (zone && zoneIndexValid)
+    {
+        auto it = zoneEntryIndex.find(zone);
+        if (it != zoneEntryIndex.end())
+            reindexZone(it->second);
+    }
 }
 
 void Buildings::clearBuildings(color_ostream& out) {
     corner1.clear();
     corner2.clear();
     locationToBuilding.clear();
+    buildingCells.clear();
+    indexedNextId = -1;
+    zoneIndexValid = false;
+    zoneEntries.clear();
+    zoneEntryIndex.clear();
+    zoneCells.clear();
 }
 
 void Buildings::updateBuildings(color_ostream&, void* ptr)
@@ -1471,21 +1935,7 @@ void Buildings::updateBuildings(color_ostream&, void* ptr)
         // existing building: destroy it
         // note that civzones are lazy-destroyed in findCivzonesAt() and are
         // not handled here
-        df::coord p1 = corner1[id];
-        df::coord p2 = corner2[id];
-
-        for ( int32_t x = p1.x; x <= p2.x; x++ ) {
-            for ( int32_t y = p1.y; y <= p2.y; y++ ) {
-                df::coord pt(x,y,p1.z);
-
-                auto cur = locationToBuilding.find(pt);
-                if (cur != locationToBuilding.end() && cur->second == id)
-                    locationToBuilding.erase(cur);
-            }
-        }
-
-        corner1.erase(id);
-        corner2.erase(id);
+        uncacheBuilding(id);
     }
 }
 
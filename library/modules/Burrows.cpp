@@ -25,6 +25,7 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
 #include <vector>
 #include <cstdlib>
 using namespace std;
@@ -135,6 +136,30 @@ void Burrows::listBlocks(std::vector<df::map_block*> *pvec, df::burrow *burrow)
     }
 }
 
+static df::coord blockPos(df::map_block *block)
+{
+    df::coord base(world->map.region_x*3,world->map.region_y*3,world->map.region_z);
+    return base + block->map_pos/16;
+}
+
+// links a new, empty mask for the burrow after prev, which must be the
+// last link in the block's list
+static df::block_burrow *linkBurrowMask(df::burrow *burrow, df::block_burrow_link *prev)
+{
+    auto link = new df::block_burrow_link;
+    link->item = new df::block_burrow;
+
+    link->item->id = burrow->id;
+    link->item->tile_bitmask.clear();
+    link->item->link = link;
+
+    link->next = NULL;
+    link->prev = prev;
+    prev->next = link;
+
+    return link->item;
+}
+
 static void destroyBurrowMask(df::block_burrow *mask)
 {
     if (!mask) return;
@@ -186,25 +211,14 @@ df::block_burrow *Burrows::getBlockMask(df::burrow *burrow, df::map_block *block
 
     if (create)
     {
-        link = new df::block_burrow_link;
-        link->item = new df::block_burrow;
-
-        link->item->id = burrow->id;
-        link->item->tile_bitmask.clear();
-        link->item->link = link;
-
-        link->next = NULL;
-        link->prev = prev;
-        prev->next = link;
-
-        df::coord base(world->map.region_x*3,world->map.region_y*3,world->map.region_z);
-        df::coord pos = base + block->map_pos/16;
+        auto mask = linkBurrowMask(burrow, prev);
 
+        df::coord pos = blockPos(block);
         burrow->block_x.push_back(pos.x);
         burrow->block_y.push_back(pos.y);
         burrow->block_z.push_back(pos.z);
 
-        return link->item;
+        return mask;
     }
 
     return NULL;
@@ -269,3 +283,272 @@ bool Burrows::setAssignedBlockTile(df::burrow *burrow, df::map_block *block, df:
 
     return true;
 }
+
+Burrows::BlockMaskCache::BlockMaskCache(df::burrow *burrow)
+    : burrow(burrow)
+{
+    CHECK_NULL_POINTER(burrow);
+
+    std::vector<df::map_block*> blocks;
+    listBlocks(&blocks, burrow);
+
+    masks.reserve(blocks.size());
+    for (auto block : blocks)
+    {
+        if (auto mask = getBlockMask(burrow, block))
+            masks.emplace(block, mask);
+    }
+}
+
+df::block_burrow *Burrows::BlockMaskCache::get(df::map_block *block, bool create)
+{
+    if (!block)
+        return NULL;
+
+    auto it = masks.find(block);
+    if (it != masks.end())
+        return it->second;
+    if (!create)
+        return NULL;
+
+    df::block_burrow_link *tail = &block->block_burrows;
+    while (tail->next)
+        tail = tail->next;
+
+    auto mask = linkBurrowMask(burrow, tail);
+
+    // a block whose mask was pruned earlier is still in the block list
+    if (!removed.erase(block))
+    {
+        df::coord pos = blockPos(block);
+        burrow->block_x.push_back(pos.x);
+        burrow->block_y.push_back(pos.y);
+        burrow->block_z.push_back(pos.z);
+    }
+
+    masks.emplace(block, mask);
+    return mask;
+}
+
+void Burrows::BlockMaskCache::prune(df::map_block *block)
+{
+    auto it = masks.find(block);
+    if (it == masks.end() || it->second->has_assignments())
+        return;
+
+    destroyBurrowMask(it->second);
+    masks.erase(it);
+    removed.insert(block);
+}
+
+bool Burrows::BlockMaskCache::isAssignedTile(df::coord tile)
+{
+    auto mask = get(Maps::getTileBlock(tile));
+    return mask ? mask->getassignment(tile.x & 15, tile.y & 15) : false;
+}
+
+bool Burrows::BlockMaskCache::setAssignedTile(df::coord tile, bool enable)
+{
+    auto block = Maps::getTileBlock(tile);
+    if (!block)
+        return false;
+
+    if (auto mask = get(block, enable))
+    {
+        mask->setassignment(tile.x & 15, tile.y & 15, enable);
+        if (!enable)
+            prune(block);
+    }
+
+    return true;
+}
+
+void Burrows::BlockMaskCache::flush()
+{
+    if (removed.empty())
+        return;
+
+    df::coord base(world->map.region_x*3,world->map.region_y*3,world->map.region_z);
+    auto &bx = burrow->block_x, &by = burrow->block_y, &bz = burrow->block_z;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < bx.size(); i++)
+    {
+        df::coord pos(bx[i], by[i], bz[i]);
+        if (removed.count(Maps::getBlock(pos - base)))
+            continue;
+
+        bx[kept] = bx[i];
+        by[kept] = by[i];
+        bz[kept] = bz[i];
+        kept++;
+    }
+
+    bx.resize(kept);
+    by.resize(kept);
+    bz.resize(kept);
+    removed.clear();
+}
+
+void Burrows::unionTiles(df::burrow *target, df::burrow *source)
+{
+    CHECK_NULL_POINTER(target);
+    CHECK_NULL_POINTER(source);
+
+    if (source == target)
+        return;
+
+    BlockMaskCache tcache(target), scache(source);
+    for (auto &[block, smask] : scache.getMasks())
+    {
+        auto tmask = tcache.get(block, true);
+        for (int j = 0; j < 16; j++)
+            tmask->tile_bitmask[j] |= smask->tile_bitmask[j];
+    }
+}
+
+void Burrows::intersectTiles(df::burrow *target, df::burrow *source)
+{
+    CHECK_NULL_POINTER(target);
+    CHECK_NULL_POINTER(source);
+
+    if (source == target)
+        return;
+
+    BlockMaskCache tcache(target), scache(source);
+
+    // pruning edits the map we would be iterating over
+    std::vector<std::pair<df::map_block*, df::block_burrow*>> tmasks(
+        tcache.getMasks().begin(), tcache.getMasks().end());
+
+    for (auto &[block, tmask] : tmasks)
+    {
+        if (auto smask = scache.get(block))
+        {
+            for (int j = 0; j < 16; j++)
+                tmask->tile_bitmask[j] &= smask->tile_bitmask[j];
+        }
+        else
+            tmask->tile_bitmask.clear();
+
+        tcache.prune(block);
+    }
+}
+
+void Burrows::subtractTiles(df::burrow *target, df::burrow *source)
+{
+    CHECK_NULL_POINTER(target);
+    CHECK_NULL_POINTER(source);
+
+    if (source == target)
+    {
+        clearTiles(target);
+        return;
+    }
+
+    BlockMaskCache tcache(target), scache(source);
+    for (auto &[block, smask] : scache.getMasks())
+    {
+        auto tmask = tcache.get(block);
+        if (!tmask)
+            continue;
+
+        for (int j = 0; j < 16; j++)
+            tmask->tile_bitmask[j] &= ~smask->tile_bitmask[j];
+        tcache.prune(block);
+    }
+}
+
+void Burrows::setTilesInBox(df::burrow *burrow, df::coord pos1, df::coord pos2, bool enable)
+{
+    CHECK_NULL_POINTER(burrow);
+
+    int32_t x_max, y_max, z_max;
+    Maps::getTileSize(x_max, y_max, z_max);
+
+    int32_t x1 = std::max<int32_t>(0, std::min(pos1.x, pos2.x));
+    int32_t y1 = std::max<int32_t>(0, std::min(pos1.y, pos2.y));
+    int32_t z1 = std::max<int32_t>(0, std::min(pos1.z, pos2.z));
+    int32_t x2 = std::min<int32_t>(x_max - 1, std::max(pos1.x, pos2.x));
+    int32_t y2 = std::min<int32_t>(y_max - 1, std::max(pos1.y, pos2.y));
+    int32_t z2 = std::min<int32_t>(z_max - 1, std::max(pos1.z, pos2.z));
+
+    BlockMaskCache cache(burrow);
+
+    for (int32_t z = z1; z <= z2; z++)
+    {
+        for (int32_t by = y1 >> 4; by <= y2 >> 4; by++)
+        {
+            int row_min = std::max(y1 - by*16, 0);
+            int row_max = std::min(y2 - by*16, 15);
+
+            for (int32_t bx = x1 >> 4; bx <= x2 >> 4; bx++)
+            {
+                int col_min = std::max(x1 - bx*16, 0);
+                int col_max = std::min(x2 - bx*16, 15);
+                uint16_t bits = uint16_t(((1u << (col_max + 1)) - 1) & ~((1u << col_min) - 1));
+
+                auto block = Maps::getBlock(bx, by, z);
+                auto mask = cache.get(block, enable);
+                if (!mask)
+                    continue;
+
+                for (int row = row_min; row <= row_max; row++)
+                {
+                    if (enable)
+                        mask->tile_bitmask[row] |= bits;
+                    else
+                        mask->tile_bitmask[row] &= ~bits;
+                }
+
+                if (!enable)
+                    cache.prune(block);
+            }
+        }
+    }
+}
+
+void Burrows::setTilesByDesignation(df::burrow *burrow, df::tile_designation mask,
+                                    df::tile_designation value, bool enable)
+{
+    CHECK_NULL_POINTER(burrow);
+
+    BlockMaskCache cache(burrow);
+
+    for (auto block : world->map.map_blocks)
+    {
+        // nothing to remove from blocks the burrow doesn't cover
+        if (!enable && !cache.get(block))
+            continue;
+
+        uint16_t rows[16];
+        bool any = false;
+        for (int y = 0; y < 16; y++)
+        {
+            rows[y] = 0;
+            for (int x = 0; x < 16; x++)
+            {
+                if ((block->designation[x][y].whole & mask.whole) == value.whole)
+                    rows[y] |= 1 << x;
+            }
+            any = any || rows[y];
+        }
+        if (!any)
+            continue;
+
+        auto bmask = cache.get(block, enable);
+        if (!bmask)
+            continue;
+
+        for (int y = 0; y < 16; y++)
+        {
+            if (enable)
+                bmask->tile_bitmask[y] |= rows[y];
+            else
+                bmask->tile_bitmask[y] &= ~rows[y];
+        }
+
+        if (!enable)
+            cache.prune(block);
+    }
+}
@@ -0,0 +1,157 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "Internal.h"
+
+#include "DataDefs.h"
+#include "PerfCounters.h"
+
+#include "modules/Clothing.h"
+#include "modules/Items.h"
+#include "modules/Materials.h"
+
+#include "df/item.h"
+#include "df/item_flags.h"
+#include "df/items_other_id.h"
+#include "df/job_material_category.h"
+#include "df/unit.h"
+#include "df/world.h"
+
+using namespace DFHack;
+using namespace df::enums;
+
+using df::global::world;
+
+static Clothing::Ledger ledger;
+static int32_t ledger_next_item_id = -1;
+
+static const df::items_other_id clothing_vectors[] = {
+    items_other_id::ARMOR,
+    items_other_id::SHOES,
+    items_other_id::HELM,
+    items_other_id::GLOVES,
+    items_other_id::PANTS,
+};
+
+uint32_t Clothing::getUnavailableFlags() {
+    static const uint32_t whole = [] {
+        df::item_flags flags;
+        #define F(x) flags.bits.x = true;
+        F(dump); F(forbid); F(garbage_collect);
+        F(hostile); F(on_fire); F(rotten); F(trader);
+        F(in_building); F(construction); F(owned);
+        F(in_chest); F(removed); F(encased);
+        F(spider_web);
+        #undef F
+        return flags.whole;
+    }();
+    return whole;
+}
+
+// MaterialInfo::matches(job_material_category) is an OR over the set bits,
+// so testing each bit on its own once per material gives a mask that answers
+// every category query with a single AND
+static uint32_t get_material_mask(std::unordered_map<uint64_t, uint32_t> &cache, df::item *item) {
+    int16_t mat_type = item->getMaterial();
+    int32_t mat_index = item->getMaterialIndex();
+    uint64_t key = (uint64_t(uint16_t(mat_type)) << 32) | uint32_t(mat_index);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    uint32_t mask = 0;
+    MaterialInfo mat(mat_type, mat_index);
+    for (int bit = 0; bit < 32; ++bit) {
+        df::job_material_category cat;
+        cat.whole = 1u << bit;
+        if (mat.matches(cat))
+            mask |= cat.whole;
+    }
+    cache.emplace(key, mask);
+    return mask;
+}
+
+static void add_item(std::unordered_map<uint64_t, uint32_t> &mat_cache, df::item *item) {
+    Clothing::SlotKey key;
+    key.type = item->getType();
+    key.subtype = item->getSubtype();
+    key.material_mask = get_material_mask(mat_cache, item);
+    key.clothing = item->isClothing();
+    bool good = item->getWear() < 1;
+
+    df::unit *owner = item->flags.bits.owned ? Items::getOwner(item) : NULL;
+    if (owner) {
+        key.race = owner->race;
+        auto &counts = ledger.owned[key];
+        if (good) {
+            ++counts.good;
+            ++ledger.owned_by_unit[owner->id][key];
+        } else {
+            ++counts.tattered;
+        }
+        return;
+    }
+
+    key.race = item->getMakerRace();
+    auto &counts = ledger.unowned[key];
+    if (!good)
+        ++counts.tattered;
+    else {
+        ++counts.good;
+        if (!(item->flags.whole & Clothing::getUnavailableFlags()))
+            ++counts.available;
+    }
+}
+
+const Clothing::Ledger &Clothing::getLedger() {
+    static auto &hist = PerfCounters::get("clothing/buildLedger");
+    static auto &hits = PerfCounters::getCounter("clothing/getLedger/cached");
+
+    int32_t next_item_id = df::global::item_next_id ? *df::global::item_next_id : -1;
+    if (ledger.frame == world->frame_counter && ledger_next_item_id == next_item_id) {
+        hits.add();
+        return ledger;
+    }
+
+    PerfTimer timer(hist);
+    invalidate();
+
+    std::unordered_map<uint64_t, uint32_t> mat_cache;
+    for (auto vec_id : clothing_vectors) {
+        for (auto item : world->items.other[vec_id])
+            add_item(mat_cache, item);
+    }
+
+    ledger.frame = world->frame_counter;
+    ledger_next_item_id = next_item_id;
+    return ledger;
+}
+
+void Clothing::invalidate() {
+    ledger.frame = -1;
+    ledger_next_item_id = -1;
+    ledger.unowned.clear();
+    ledger.owned.clear();
+    ledger.owned_by_unit.clear();
+}
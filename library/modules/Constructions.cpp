@@ -151,6 +151,7 @@ bool Constructions::designateRemove(df::coord pos, bool *immediate)
         auto &dsgn = block->designation[pos.x&15][pos.y&15];
         dsgn.bits.dig = tile_dig_designation::Default;
         block->flags.bits.designated = true;
+        Maps::invalidateDesignationCensus(block);
         if (process_dig)
             *process_dig = true;
         return true;
@@ -99,6 +99,7 @@ bool Designations::markPlant(const df::plant *plant)
         df::map_block *block = Maps::getTileBlock(des_pos);
         block->designation[des_pos.x % 16][des_pos.y % 16].bits.dig = tile_dig_designation::Default;
         block->flags.bits.designated = true;
+        Maps::invalidateDesignationCensus(block);
         return true;
     }
     else
@@ -127,6 +128,7 @@ bool Designations::unmarkPlant(const df::plant *plant)
         df::map_block *block = Maps::getTileBlock(des_pos);
         block->designation[des_pos.x % 16][des_pos.y % 16].bits.dig = tile_dig_designation::No;
         block->flags.bits.designated = true;
+        Maps::invalidateDesignationCensus(block);
 
         auto *link = world->jobs.list.next;
         while (link)
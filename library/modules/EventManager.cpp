@@ -1,6 +1,8 @@
 #include "Core.h"
 #include "Console.h"
 #include "Debug.h"
+#include "MiscUtils.h"
+#include "PerfCounters.h"
 #include "VTableInterpose.h"
 #include "modules/Buildings.h"
 #include "modules/Constructions.h"
@@ -10,6 +12,8 @@
 #include "modules/Units.h"
 #include "modules/World.h"
 
+#include "EventManagerInternal.h"
+
 #include "df/announcement_type.h"
 #include "df/building.h"
 #include "df/construction.h"
@@ -38,6 +42,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
+#include <limits>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -60,22 +66,78 @@ using namespace df::enums;
  *  consider a typedef instead of a struct for EventHandler
  **/
 
-static multimap<int32_t, EventHandler> tickQueue;
-
 //TODO: consider unordered_map of pairs, or unordered_map of unordered_set, or whatever
+//TICK handlers are not kept here; they live in tickWheel
 static multimap<Plugin*, EventHandler> handlers[EventType::EVENT_MAX];
 static int32_t eventLastTick[EventType::EVENT_MAX];
 
+static const char *eventNames[EventType::EVENT_MAX] = {
+    "TICK",
+    "JOB_INITIATED",
+    "JOB_STARTED",
+    "JOB_COMPLETED",
+    "UNIT_NEW_ACTIVE",
+    "UNIT_DEATH",
+    "ITEM_CREATED",
+    "BUILDING",
+    "CONSTRUCTION",
+    "SYNDROME",
+    "INVASION",
+    "INVENTORY_CHANGE",
+    "REPORT",
+    "UNIT_ATTACK",
+    "UNLOAD",
+    "INTERACTION",
+};
+
+struct hash_pair {
+    template<typename A, typename B>
+    size_t operator()(const std::pair<A,B>& p) const {
+        auto h1 = std::hash<A>{}(p.first);
+        auto h2 = std::hash<B>{}(p.second);
+        return h1 ^ (h2 << 1);
+    }
+};
+
+// latency histograms are looked up by name once and cached here. handler
+// histograms are keyed by plugin as well, since plugins can share a callback
+static LatencyHistogram *scanLatency[EventType::EVENT_MAX];
+static unordered_map<std::pair<Plugin*, intptr_t>, LatencyHistogram*, hash_pair> handlerLatency[EventType::EVENT_MAX];
+
+static LatencyHistogram &getScanLatency(EventType::EventType e) {
+    if (!scanLatency[e])
+        scanLatency[e] = &PerfCounters::get(stl_sprintf("events/%s", eventNames[e]));
+    return *scanLatency[e];
+}
+
+static void invokeHandler(color_ostream& out, EventType::EventType e, Plugin* plugin, const EventHandler& handle, void* data) {
+    LatencyHistogram *&hist = handlerLatency[e][std::make_pair(plugin, intptr_t(handle.eventHandler))];
+    if (!hist) {
+        hist = &PerfCounters::get(stl_sprintf("events/%s/%s@%p", eventNames[e],
+            plugin ? plugin->getName().c_str() : "core", (void*)handle.eventHandler));
+    }
+    PerfTimer timer(*hist);
+    handle.eventHandler(out, data);
+}
+
+static EventManager::Internal::TickWheel tickWheel;
+
 static const int32_t ticksPerYear = 403200;
 
+static void resetReportIndex();
+
 void DFHack::EventManager::registerListener(EventType::EventType e, EventHandler handler, Plugin* plugin) {
     DEBUG(log).print("registering handler %p from plugin %s for event %d\n", handler.eventHandler, plugin->getName().c_str(), e);
+    if ( (e == EventType::UNIT_ATTACK || e == EventType::INTERACTION) && handlers[e].empty() ) {
+        // the report index was pruned without this consumer's cursor, so start over
+        resetReportIndex();
+    }
     handlers[e].insert(pair<Plugin*, EventHandler>(plugin, handler));
 }
 
-int32_t DFHack::EventManager::registerTick(EventHandler handler, int32_t when, Plugin* plugin, bool absolute) {
+static TickHandle scheduleTickAt(EventHandler handler, int32_t &when, Plugin* plugin, bool absolute) {
+    df::world* world = df::global::world;
     if ( !absolute ) {
-        df::world* world = df::global::world;
         if ( world ) {
             when += world->frame_counter;
         } else {
@@ -83,26 +145,40 @@ int32_t DFHack::EventManager::registerTick(EventHandler handler, int32_t when, P
                 Core::getInstance().getConsole().print("EventManager::registerTick: warning! absolute flag=false not honored.\n");
         }
     }
+    if ( world )
+        tickWheel.rewind(world->frame_counter);
     handler.freq = when;
-    tickQueue.insert(pair<int32_t, EventHandler>(handler.freq, handler));
     DEBUG(log).print("registering handler %p from plugin %s for event TICK\n", handler.eventHandler, plugin->getName().c_str());
-    handlers[EventType::TICK].insert(pair<Plugin*,EventHandler>(plugin,handler));
+    return tickWheel.schedule(handler, when, plugin);
+}
+
+int32_t DFHack::EventManager::registerTick(EventHandler handler, int32_t when, Plugin* plugin, bool absolute) {
+    scheduleTickAt(handler, when, plugin, absolute);
     return when;
 }
 
-static void removeFromTickQueue(EventHandler getRidOf) {
-    for ( auto j = tickQueue.find(getRidOf.freq); j != tickQueue.end(); ) {
-        if ( (*j).first > getRidOf.freq )
-            break;
-        if ( (*j).second != getRidOf ) {
-            j++;
-            continue;
-        }
-        j = tickQueue.erase(j);
-    }
+TickHandle DFHack::EventManager::scheduleTick(EventHandler handler, int32_t when, Plugin* plugin, bool absolute) {
+    return scheduleTickAt(handler, when, plugin, absolute);
+}
+
+bool DFHack::EventManager::cancelTick(TickHandle handle) {
+    return tickWheel.cancel(handle);
+}
+
+size_t DFHack::EventManager::getTickQueueDepth() {
+    return tickWheel.size();
+}
+
+std::map<Plugin*, size_t> DFHack::EventManager::getTickCountsByPlugin() {
+    return tickWheel.getPluginCounts();
 }
 
 void DFHack::EventManager::unregister(EventType::EventType e, EventHandler handler, Plugin* plugin) {
+    if ( e == EventType::TICK ) {
+        DEBUG(log).print("unregistering handler %p from plugin %s for event TICK\n", handler.eventHandler, plugin->getName().c_str());
+        tickWheel.cancel(plugin, handler);
+        return;
+    }
     for ( auto i = handlers[e].find(plugin); i != handlers[e].end(); ) {
         if ( (*i).first != plugin )
             break;
@@ -113,19 +189,12 @@ void DFHack::EventManager::unregister(EventType::EventType e, EventHandler handl
         }
         DEBUG(log).print("unregistering handler %p from plugin %s for event %d\n", handler.eventHandler, plugin->getName().c_str(), e);
         i = handlers[e].erase(i);
-        if ( e == EventType::TICK )
-            removeFromTickQueue(handler);
     }
 }
 
 void DFHack::EventManager::unregisterAll(Plugin* plugin) {
     DEBUG(log).print("unregistering all handlers for plugin %s\n", plugin->getName().c_str());
-    for ( auto i = handlers[EventType::TICK].find(plugin); i != handlers[EventType::TICK].end(); i++ ) {
-        if ( (*i).first != plugin )
-            break;
-
-        removeFromTickQueue((*i).second);
-    }
+    tickWheel.cancelAll(plugin);
     for (auto &handler : handlers) {
         handler.erase(plugin);
     }
@@ -210,7 +279,23 @@ static int32_t lastJobId = -1;
 static unordered_set<int32_t> startedJobs;
 
 //job completed
-static unordered_map<int32_t, df::job*> prevJobs;
+// compact per-job state needed to detect completion; a full clone of the job
+// is only kept for jobs that are on the verge of completing (completion_timer
+// of 0), since those are the only ones that can be reported to handlers
+struct JobSnapshot {
+    int32_t id;
+    int32_t completion_timer;
+    bool repeat;
+    df::job* clone;
+
+    bool operator<(const JobSnapshot &other) const {
+        return id < other.id;
+    }
+};
+// both tables are kept sorted by job id and are swapped every poll so their
+// storage is reused; a steady-state poll does not touch the heap
+static vector<JobSnapshot> prevJobs;
+static vector<JobSnapshot> nowJobs;
 
 //active units
 static unordered_set<int32_t> activeUnits;
@@ -236,29 +321,44 @@ static int32_t lastSyndromeTime;
 static int32_t nextInvasion;
 
 //equipment change
-//static unordered_map<int32_t, vector<df::unit_inventory_item> > equipmentLog;
-static unordered_map<int32_t, vector<InventoryItem> > equipmentLog;
+struct InventorySnapshot {
+    uint64_t fingerprint;
+    vector<InventoryItem> items; // sorted by item id
+};
+// indices into changedItems, or -1 for no item
+struct InventoryChangeRecord {
+    int32_t unitId;
+    int32_t old_idx;
+    int32_t new_idx;
+};
+static unordered_map<int32_t, InventorySnapshot> equipmentLog;
+// per-poll scratch storage, cleared (but not freed) at the start of each poll
+static vector<InventoryItem> newEquipment;
+static vector<InventoryItem> changedItems;
+static vector<InventoryChangeRecord> equipmentPickups;
+static vector<InventoryChangeRecord> equipmentDrops;
+static vector<InventoryChangeRecord> equipmentChanges;
 
 //report
 static int32_t lastReport;
 
 //unit attack
 static int32_t lastReportUnitAttack;
-static std::map<int32_t,std::vector<int32_t> > reportToRelevantUnits;
+// entries are evicted once the attack and interaction cursors pass them, and the
+// whole index is rebuilt when a consumer registers after its entries were dropped
+static EventManager::Internal::ReportUnitIndex reportToRelevantUnits;
 static int32_t reportToRelevantUnitsTime = -1;
+static int32_t lastScannedReport = -1;
+
+static void resetReportIndex() {
+    reportToRelevantUnits.clear();
+    reportToRelevantUnitsTime = -1;
+    lastScannedReport = -1;
+}
 
 //interaction
 static int32_t lastReportInteraction;
 
-struct hash_pair {
-    template<typename A, typename B>
-    size_t operator()(const std::pair<A,B>& p) const {
-        auto h1 = std::hash<A>{}(p.first);
-        auto h2 = std::hash<B>{}(p.second);
-        return h1 ^ (h2 << 1);
-    }
-};
-
 void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event event) {
     static bool doOnce = false;
 //    const string eventNames[] = {"world loaded", "world unloaded", "map loaded", "map unloaded", "viewscreen changed", "core initialized", "begin unload", "paused", "unpaused"};
@@ -274,10 +374,12 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         lastJobId = -1;
         startedJobs.clear();
         for (auto &prevJob : prevJobs) {
-            Job::deleteJobStruct(prevJob.second, true);
+            if (prevJob.clone)
+                Job::deleteJobStruct(prevJob.clone, true);
         }
         prevJobs.clear();
-        tickQueue.clear();
+        nowJobs.clear();
+        tickWheel.clear();
         livingUnits.clear();
         buildings.clear();
         constructions.clear();
@@ -290,9 +392,9 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         gameLoaded = false;
 
         multimap<Plugin*,EventHandler> copy(handlers[EventType::UNLOAD].begin(), handlers[EventType::UNLOAD].end());
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for map unloaded state change event\n");
-            handle.eventHandler(out, nullptr);
+            invokeHandler(out, EventType::UNLOAD, plugin, handle, nullptr);
         }
     } else if ( event == DFHack::SC_MAP_LOADED ) {
         /*
@@ -357,8 +459,7 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         }
         lastReportUnitAttack = -1;
         lastReportInteraction = -1;
-        reportToRelevantUnitsTime = -1;
-        reportToRelevantUnits.clear();
+        resetReportIndex();
         for (int &last_tick : eventLastTick) {
             last_tick = -1;//-1000000;
         }
@@ -385,7 +486,7 @@ void DFHack::EventManager::manageEvents(color_ostream& out) {
     TRACE(log,out).print("processing events at tick %d\n", tick);
 
     for ( size_t a = 0; a < EventType::EVENT_MAX; a++ ) {
-        if ( handlers[a].empty() )
+        if ( a == EventType::TICK ? tickWheel.empty() : handlers[a].empty() )
             continue;
         int32_t eventFrequency = -100;
         if ( a != EventType::TICK )
@@ -398,7 +499,10 @@ void DFHack::EventManager::manageEvents(color_ostream& out) {
         if ( tick >= eventLastTick[a] && tick - eventLastTick[a] < eventFrequency )
             continue;
 
-        eventManager[a](out);
+        {
+            PerfTimer timer(getScanLatency((EventType::EventType)a));
+            eventManager[a](out);
+        }
         eventLastTick[a] = tick;
     }
 }
@@ -406,30 +510,11 @@ void DFHack::EventManager::manageEvents(color_ostream& out) {
 static void manageTickEvent(color_ostream& out) {
     if (!df::global::world)
         return;
-    unordered_set<EventHandler> toRemove;
     int32_t tick = df::global::world->frame_counter;
-    while ( !tickQueue.empty() ) {
-        if ( tick < (*tickQueue.begin()).first )
-            break;
-        EventHandler &handle = (*tickQueue.begin()).second;
-        tickQueue.erase(tickQueue.begin());
+    tickWheel.fire(tick, [&](Plugin *plugin, const EventHandler &handler) {
         DEBUG(log,out).print("calling handler for tick event\n");
-        handle.eventHandler(out, (void*)intptr_t(tick));
-        toRemove.insert(handle);
-    }
-    if ( toRemove.empty() )
-        return;
-    for ( auto a = handlers[EventType::TICK].begin(); a != handlers[EventType::TICK].end(); ) {
-        EventHandler &handle = (*a).second;
-        if ( toRemove.find(handle) == toRemove.end() ) {
-            a++;
-            continue;
-        }
-        a = handlers[EventType::TICK].erase(a);
-        toRemove.erase(handle);
-        if ( toRemove.empty() )
-            break;
-    }
+        invokeHandler(out, EventType::TICK, plugin, handler, (void*)intptr_t(tick));
+    });
 }
 
 static void manageJobInitiatedEvent(color_ostream& out) {
@@ -452,9 +537,9 @@ static void manageJobInitiatedEvent(color_ostream& out) {
             continue;
         if ( link->item->id <= lastJobId )
             continue;
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for job initiated event\n");
-            handle.eventHandler(out, (void*)link->item);
+            invokeHandler(out, EventType::JOB_INITIATED, plugin, handle, (void*)link->item);
         }
     }
 
@@ -478,9 +563,9 @@ static void manageJobStartedEvent(color_ostream& out) {
         int32_t j_id = job->id;
         newStartedJobs.emplace(j_id);
         if (!startedJobs.count(j_id)) {
-            for (auto &[_,handle] : copy) {
+            for (auto &[plugin,handle] : copy) {
                 DEBUG(log,out).print("calling handler for job started event\n");
-                handle.eventHandler(out, job);
+                invokeHandler(out, EventType::JOB_STARTED, plugin, handle, job);
             }
         }
     }
@@ -488,12 +573,6 @@ static void manageJobStartedEvent(color_ostream& out) {
     startedJobs = newStartedJobs;
 }
 
-//helper function for manageJobCompletedEvent
-//static int32_t getWorkerID(df::job* job) {
-//    auto ref = findRef(job->general_refs, general_ref_type::UNIT_WORKER);
-//    return ref ? ref->getID() : -1;
-//}
-
 /*
 TODO: consider checking item creation / experience gain just in case
 */
@@ -505,126 +584,67 @@ static void manageJobCompletedEvent(color_ostream& out) {
     int32_t tick1 = df::global::world->frame_counter;
 
     multimap<Plugin*,EventHandler> copy(handlers[EventType::JOB_COMPLETED].begin(), handlers[EventType::JOB_COMPLETED].end());
-    unordered_map<int32_t, df::job*> nowJobs;
-    for ( df::job_list_link* link = &df::global::world->jobs.list; link != nullptr; link = link->next ) {
-        if ( link->item == nullptr )
-            continue;
-        nowJobs.emplace(link->item->id, link->item);
-    }
 
-#if 0
-    //testing info on job initiation/completion
-    //newly allocated jobs
-    for ( auto j = nowJobs.begin(); j != nowJobs.end(); j++ ) {
-        if ( prevJobs.find((*j).first) != prevJobs.end() )
+    nowJobs.clear();
+    bool sorted = true;
+    for ( df::job_list_link* link = &df::global::world->jobs.list; link != nullptr; link = link->next ) {
+        df::job* job = link->item;
+        if ( job == nullptr )
             continue;
-
-        df::job& job1 = *(*j).second;
-        out.print("new job\n"
-            "  location         : 0x%X\n"
-            "  id               : %d\n"
-            "  type             : %d %s\n"
-            "  working          : %d\n"
-            "  completion_timer : %d\n"
-            "  workerID         : %d\n"
-            "  time             : %d -> %d\n"
-            "\n", job1.list_link->item, job1.id, job1.job_type, ENUM_ATTR(job_type, caption, job1.job_type), job1.flags.bits.working, job1.completion_timer, getWorkerID(&job1), tick0, tick1);
+        if ( !nowJobs.empty() && nowJobs.back().id > job->id )
+            sorted = false;
+        // only jobs that are about to finish need their full state preserved
+        df::job* clone = job->completion_timer == 0 ? Job::cloneJobStruct(job, true) : nullptr;
+        nowJobs.push_back({ job->id, job->completion_timer, (bool)job->flags.bits.repeat, clone });
     }
-    for ( auto i = prevJobs.begin(); i != prevJobs.end(); i++ ) {
-        df::job& job0 = *(*i).second;
-        auto j = nowJobs.find((*i).first);
-        if ( j == nowJobs.end() ) {
-            out.print("job deallocated\n"
-                "  location         : 0x%X\n"
-                "  id               : %d\n"
-                "  type             : %d %s\n"
-                "  working          : %d\n"
-                "  completion_timer : %d\n"
-                "  workerID         : %d\n"
-                "  time             : %d -> %d\n"
-                ,job0.list_link == NULL ? 0 : job0.list_link->item, job0.id, job0.job_type, ENUM_ATTR(job_type, caption, job0.job_type), job0.flags.bits.working, job0.completion_timer, getWorkerID(&job0), tick0, tick1);
-            continue;
-        }
-        df::job& job1 = *(*j).second;
-
-        if ( job0.flags.bits.working == job1.flags.bits.working &&
-               (job0.completion_timer == job1.completion_timer || (job1.completion_timer > 0 && job0.completion_timer-1 == job1.completion_timer)) &&
-               getWorkerID(&job0) == getWorkerID(&job1) )
-            continue;
+    // the job list is normally in creation (and therefore id) order
+    if ( !sorted )
+        std::sort(nowJobs.begin(), nowJobs.end());
+
+    //if it happened within a tick, must have been cancelled by the user or a plugin: not completed
+    if ( tick1 > tick0 ) {
+        auto now = nowJobs.begin();
+        for (auto &job0 : prevJobs) {
+            // only jobs with a completion timer of 0 at the last poll can have completed since
+            if ( !job0.clone )
+                continue;
 
-        out.print("job change\n"
-            "  location         : 0x%X -> 0x%X\n"
-            "  id               : %d -> %d\n"
-            "  type             : %d -> %d\n"
-            "  type             : %s -> %s\n"
-            "  working          : %d -> %d\n"
-            "  completion timer : %d -> %d\n"
-            "  workerID         : %d -> %d\n"
-            "  time             : %d -> %d\n"
-            "\n",
-            job0.list_link->item, job1.list_link->item,
-            job0.id, job1.id,
-            job0.job_type, job1.job_type,
-            ENUM_ATTR(job_type, caption, job0.job_type), ENUM_ATTR(job_type, caption, job1.job_type),
-            job0.flags.bits.working, job1.flags.bits.working,
-            job0.completion_timer, job1.completion_timer,
-            getWorkerID(&job0), getWorkerID(&job1),
-            tick0, tick1
-        );
-    }
-#endif
+            while ( now != nowJobs.end() && now->id < job0.id )
+                ++now;
 
-    for (auto &prevJob : prevJobs) {
-        //if it happened within a tick, must have been cancelled by the user or a plugin: not completed
-        if ( tick1 <= tick0 )
-            continue;
+            if ( now != nowJobs.end() && now->id == job0.id ) {
+                //could have just finished if it's a repeat job
+                if ( !job0.repeat )
+                    continue;
+                if ( now->completion_timer != -1 )
+                    continue;
 
-        if ( nowJobs.find(prevJob.first) != nowJobs.end() ) {
-            //could have just finished if it's a repeat job
-            df::job& job0 = *prevJob.second;
-            if ( !job0.flags.bits.repeat )
-                continue;
-            df::job& job1 = *nowJobs[prevJob.first];
-            if ( job0.completion_timer != 0 )
-                continue;
-            if ( job1.completion_timer != -1 )
+                //still false positive if cancelled at EXACTLY the right time, but experiments show this doesn't happen
+                for (auto &[plugin,handle] : copy) {
+                    DEBUG(log,out).print("calling handler for repeated job completed event\n");
+                    invokeHandler(out, EventType::JOB_COMPLETED, plugin, handle, (void*) job0.clone);
+                }
                 continue;
-
-            //still false positive if cancelled at EXACTLY the right time, but experiments show this doesn't happen
-            for (auto &[_,handle] : copy) {
-                DEBUG(log,out).print("calling handler for repeated job completed event\n");
-                handle.eventHandler(out, (void*) &job0);
             }
-            continue;
-        }
 
-        //recently finished or cancelled job
-        df::job& job0 = *prevJob.second;
-        if ( job0.flags.bits.repeat || job0.completion_timer != 0 )
-            continue;
+            //recently finished or cancelled job
+            if ( job0.repeat )
+                continue;
 
-        for (auto &[_,handle] : copy) {
-            DEBUG(log,out).print("calling handler for job completed event\n");
-            handle.eventHandler(out, (void*) &job0);
+            for (auto &[plugin,handle] : copy) {
+                DEBUG(log,out).print("calling handler for job completed event\n");
+                invokeHandler(out, EventType::JOB_COMPLETED, plugin, handle, (void*) job0.clone);
+            }
         }
     }
 
-    //erase old jobs, copy over possibly altered jobs
-    for (auto &[_,prev_job] : prevJobs) {
-        Job::deleteJobStruct(prev_job, true);
-    }
-    prevJobs.clear();
-
-    //create new jobs
-    for (auto &[_,now_job] : nowJobs) {
-        /*map<int32_t, df::job*>::iterator i = prevJobs.find((*j).first);
-        if ( i != prevJobs.end() ) {
-            continue;
-        }*/
-
-        df::job* newJob = Job::cloneJobStruct(now_job, true);
-        prevJobs.emplace(newJob->id, newJob);
+    //erase old snapshots and keep the new ones for the next poll
+    for (auto &job0 : prevJobs) {
+        if (job0.clone)
+            Job::deleteJobStruct(job0.clone, true);
     }
+    prevJobs.swap(nowJobs);
+    nowJobs.clear();
 }
 
 static void manageNewUnitActiveEvent(color_ostream& out) {
@@ -641,9 +661,9 @@ static void manageNewUnitActiveEvent(color_ostream& out) {
         }
     }
     for (int32_t unit_id : new_active_unit_ids) {
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for new unit event\n");
-            handle.eventHandler(out, (void*) intptr_t(unit_id)); // intptr_t() avoids cast from smaller type warning
+            invokeHandler(out, EventType::UNIT_NEW_ACTIVE, plugin, handle, (void*) intptr_t(unit_id)); // intptr_t() avoids cast from smaller type warning
         }
     }
 }
@@ -669,9 +689,9 @@ static void manageUnitDeathEvent(color_ostream& out) {
     }
 
     for (int32_t unit_id : dead_unit_ids) {
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for unit death event\n");
-            handle.eventHandler(out, (void*)intptr_t(unit_id));
+            invokeHandler(out, EventType::UNIT_DEATH, plugin, handle, (void*)intptr_t(unit_id));
         }
     }
 }
@@ -712,9 +732,9 @@ static void manageItemCreationEvent(color_ostream& out) {
 
     // handle all created items
     for (int32_t item_id : created_items) {
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for item created event\n");
-            handle.eventHandler(out, (void*)intptr_t(item_id));
+            invokeHandler(out, EventType::ITEM_CREATED, plugin, handle, (void*)intptr_t(item_id));
         }
     }
 
@@ -755,18 +775,18 @@ static void manageBuildingEvent(color_ostream& out) {
             continue;
         }
 
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for destroyed building event\n");
-            handle.eventHandler(out, (void*)intptr_t(id));
+            invokeHandler(out, EventType::BUILDING, plugin, handle, (void*)intptr_t(id));
         }
         it = buildings.erase(it);
     }
 
     //alert people about newly created buildings
     std::for_each(new_buildings.begin(), new_buildings.end(), [&](int32_t building){
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for created building event\n");
-            handle.eventHandler(out, (void*)intptr_t(building));
+            invokeHandler(out, EventType::BUILDING, plugin, handle, (void*)intptr_t(building));
         }
     });
 }
@@ -801,17 +821,17 @@ static void manageConstructionEvent(color_ostream& out) {
     // now next_construction_set contains all the constructions that were removed (not found in df::global::world->constructions)
     for (auto& construction : next_construction_set) {
         // handle construction removed event
-        for (const auto &[_,handle]: copy) {
+        for (const auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for destroyed construction event\n");
-            handle.eventHandler(out, (void*) &construction);
+            invokeHandler(out, EventType::CONSTRUCTION, plugin, handle, (void*) &construction);
         }
     }
 
     // now handle all the new constructions
     for (auto& construction : new_constructions) {
-        for (const auto &[_,handle]: copy) {
+        for (const auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for created construction event\n");
-            handle.eventHandler(out, (void*) &construction);
+            invokeHandler(out, EventType::CONSTRUCTION, plugin, handle, (void*) &construction);
         }
     }
 }
@@ -841,9 +861,9 @@ static void manageSyndromeEvent(color_ostream& out) {
         }
     }
     for (auto& data : new_syndrome_data) {
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for syndrome event\n");
-            handle.eventHandler(out, (void*)&data);
+            invokeHandler(out, EventType::SYNDROME, plugin, handle, (void*)&data);
         }
     }
 
@@ -859,119 +879,126 @@ static void manageInvasionEvent(color_ostream& out) {
         return;
     nextInvasion = df::global::plotinfo->invasions.next_id;
 
-    for (auto &[_,handle] : copy) {
+    for (auto &[plugin,handle] : copy) {
         DEBUG(log,out).print("calling handler for invasion event\n");
-        handle.eventHandler(out, (void*)intptr_t(nextInvasion-1));
+        invokeHandler(out, EventType::INVASION, plugin, handle, (void*)intptr_t(nextInvasion-1));
     }
 }
 
+// cheap order-sensitive hash over everything that can produce an inventory
+// change event; units whose fingerprint is unchanged are skipped entirely
+static uint64_t getInventoryFingerprint(const vector<df::unit_inventory_item*>& inventory) {
+    uint64_t r = 17 + inventory.size();
+    const uint64_t m = 65537;
+    for (auto dfitem : inventory) {
+        r = m*(r+dfitem->item->id);
+        r = m*(r+dfitem->mode);
+        r = m*(r+dfitem->body_part_id);
+        r = m*(r+dfitem->wound_id);
+    }
+    return r;
+}
+
+// confirms a fingerprint match against the stored (id-sorted) item list, so a hash
+// collision can't hide a real change
+static bool inventoryMatches(const vector<InventoryItem>& items, const vector<df::unit_inventory_item*>& inventory) {
+    if ( items.size() != inventory.size() )
+        return false;
+    for (auto dfitem : inventory) {
+        auto it = std::lower_bound(items.begin(), items.end(), dfitem->item->id, [](const InventoryItem& a, int32_t id) {
+            return a.itemId < id;
+        });
+        if ( it == items.end() || it->itemId != dfitem->item->id )
+            return false;
+        const df::unit_inventory_item& old = it->item;
+        if ( old.mode != dfitem->mode || old.body_part_id != dfitem->body_part_id || old.wound_id != dfitem->wound_id )
+            return false;
+    }
+    return true;
+}
+
 static void manageEquipmentEvent(color_ostream& out) {
     if (!df::global::world)
         return;
     multimap<Plugin*,EventHandler> copy(handlers[EventType::INVENTORY_CHANGE].begin(), handlers[EventType::INVENTORY_CHANGE].end());
 
-    unordered_map<int32_t, InventoryItem> itemIdToInventoryItem;
-    unordered_set<int32_t> currentlyEquipped;
-
-    vector<InventoryChangeData> equipment_pickups;
-    vector<InventoryChangeData> equipment_drops;
-    vector<InventoryChangeData> equipment_changes;
-
+    changedItems.clear();
+    equipmentPickups.clear();
+    equipmentDrops.clear();
+    equipmentChanges.clear();
 
-    // This vector stores the pointers to newly created changed items
-    // needed as the stack allocated temporary (in the loop) is lost when we go to
-    // handle the event calls, so we move that data to the heap if its needed,
-    // and then once we are done we delete everything.
-    vector<InventoryItem*> changed_items;
+    auto addChangedItem = [](const InventoryItem& item) -> int32_t {
+        changedItems.push_back(item);
+        return (int32_t)changedItems.size() - 1;
+    };
 
     for (auto unit : df::global::world->units.all) {
-        itemIdToInventoryItem.clear();
-        currentlyEquipped.clear();
-        /*if ( unit->flags1.bits.inactive )
+        auto oldEquipment = equipmentLog.find(unit->id);
+        if ( oldEquipment == equipmentLog.end() && unit->inventory.empty() )
             continue;
-        */
 
-        auto oldEquipment = equipmentLog.find(unit->id);
-        bool hadEquipment = oldEquipment != equipmentLog.end();
-        vector<InventoryItem>* temp;
-        if ( hadEquipment ) {
-            temp = &((*oldEquipment).second);
-        } else {
-            temp = new vector<InventoryItem>;
-        }
-        //vector<InventoryItem>& v = (*oldEquipment).second;
-        vector<InventoryItem>& v = *temp;
-        for (auto & i : v) {
-            itemIdToInventoryItem[i.itemId] = i;
+        uint64_t fingerprint = getInventoryFingerprint(unit->inventory);
+        if ( oldEquipment != equipmentLog.end() && oldEquipment->second.fingerprint == fingerprint
+                && inventoryMatches(oldEquipment->second.items, unit->inventory) )
+            continue;
+
+        InventorySnapshot& snapshot = oldEquipment != equipmentLog.end() ? oldEquipment->second : equipmentLog[unit->id];
+        vector<InventoryItem>& v = snapshot.items;
+
+        newEquipment.clear();
+        for (auto dfitem : unit->inventory) {
+            newEquipment.emplace_back(dfitem->item->id, *dfitem);
         }
-        for ( size_t b = 0; b < unit->inventory.size(); b++ ) {
-            df::unit_inventory_item* dfitem_new = unit->inventory[b];
-            currentlyEquipped.insert(dfitem_new->item->id);
-            InventoryItem item_new(dfitem_new->item->id, *dfitem_new);
-            auto c = itemIdToInventoryItem.find(dfitem_new->item->id);
-            if ( c == itemIdToInventoryItem.end() ) {
+        std::sort(newEquipment.begin(), newEquipment.end(), [](const InventoryItem& a, const InventoryItem& b) {
+            return a.itemId < b.itemId;
+        });
+
+        // both lists are sorted by item id, so pickups, drops, and changes fall out of a single merge
+        auto i = v.begin();
+        auto j = newEquipment.begin();
+        while ( i != v.end() || j != newEquipment.end() ) {
+            if ( j == newEquipment.end() || (i != v.end() && i->itemId < j->itemId) ) {
+                //dropped item
+                equipmentDrops.push_back({ unit->id, addChangedItem(*i), -1 });
+                ++i;
+            } else if ( i == v.end() || j->itemId < i->itemId ) {
                 //new item equipped (probably just picked up)
-                changed_items.emplace_back(new InventoryItem(item_new));
-                equipment_pickups.emplace_back(unit->id, nullptr, changed_items.back());
-                continue;
+                equipmentPickups.push_back({ unit->id, -1, addChangedItem(*j) });
+                ++j;
+            } else {
+                df::unit_inventory_item& item0 = i->item;
+                df::unit_inventory_item& item1 = j->item;
+                if ( item0.mode != item1.mode || item0.body_part_id != item1.body_part_id || item0.wound_id != item1.wound_id ) {
+                    //some sort of change in how it's equipped
+                    int32_t new_idx = addChangedItem(*j);
+                    int32_t old_idx = addChangedItem(*i);
+                    equipmentChanges.push_back({ unit->id, old_idx, new_idx });
+                }
+                ++i;
+                ++j;
             }
-            InventoryItem item_old = c->second;
-
-            df::unit_inventory_item& item0 = item_old.item;
-            df::unit_inventory_item& item1 = item_new.item;
-            if ( item0.mode == item1.mode && item0.body_part_id == item1.body_part_id && item0.wound_id == item1.wound_id )
-                continue;
-            //some sort of change in how it's equipped
-            changed_items.emplace_back(new InventoryItem(item_new));
-            InventoryItem* item_new_ptr = changed_items.back();
-            changed_items.emplace_back(new InventoryItem(item_old));
-            InventoryItem* item_old_ptr = changed_items.back();
-            equipment_changes.emplace_back(unit->id, item_old_ptr, item_new_ptr);
         }
-        //check for dropped items
-        for (auto i : v) {
-            if ( currentlyEquipped.find(i.itemId) != currentlyEquipped.end() )
-                continue;
-            //TODO: delete ptr if invalid
-            changed_items.emplace_back(new InventoryItem(i));
-            equipment_drops.emplace_back(unit->id, changed_items.back(), nullptr);
-        }
-        if ( !hadEquipment )
-            delete temp;
 
-        //update equipment
-        vector<InventoryItem>& equipment = equipmentLog[unit->id];
-        equipment.clear();
-        for (auto dfitem : unit->inventory) {
-            InventoryItem item(dfitem->item->id, *dfitem);
-            equipment.push_back(item);
-        }
+        //update equipment; the old vector's storage is kept around for the next unit
+        snapshot.fingerprint = fingerprint;
+        v.swap(newEquipment);
     }
 
     // now handle events
-    std::for_each(equipment_pickups.begin(), equipment_pickups.end(), [&](InventoryChangeData& data) {
-        for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for new item equipped inventory change event\n");
-            handle.eventHandler(out, (void*) &data);
-        }
-    });
-    std::for_each(equipment_drops.begin(), equipment_drops.end(), [&](InventoryChangeData& data) {
-        for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for dropped item inventory change event\n");
-            handle.eventHandler(out, (void*) &data);
-        }
-    });
-    std::for_each(equipment_changes.begin(), equipment_changes.end(), [&](InventoryChangeData& data) {
-        for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for inventory change event\n");
-            handle.eventHandler(out, (void*) &data);
+    auto dispatch = [&](const vector<InventoryChangeRecord>& records, const char* what) {
+        for (auto& record : records) {
+            InventoryChangeData data(record.unitId,
+                                     record.old_idx < 0 ? nullptr : &changedItems[record.old_idx],
+                                     record.new_idx < 0 ? nullptr : &changedItems[record.new_idx]);
+            for (auto &[plugin,handle] : copy) {
+                DEBUG(log,out).print("calling handler for %s inventory change event\n", what);
+                invokeHandler(out, EventType::INVENTORY_CHANGE, plugin, handle, (void*) &data);
+            }
         }
-    });
-
-    // clean up changed items list
-    std::for_each(changed_items.begin(), changed_items.end(), [](InventoryItem* p){
-        delete p;
-    });
+    };
+    dispatch(equipmentPickups, "new item equipped");
+    dispatch(equipmentDrops, "dropped item");
+    dispatch(equipmentChanges, "changed item");
 }
 
 static void updateReportToRelevantUnits() {
@@ -981,18 +1008,36 @@ static void updateReportToRelevantUnits() {
         return;
     reportToRelevantUnitsTime = df::global::world->frame_counter;
 
+    // unit logs only gain entries when reports are made, so there is nothing to
+    // pick up until a report newer than the last scan shows up
+    std::vector<df::report*>& reports = df::global::world->status.reports;
+    if ( reports.empty() || reports.back()->id <= lastScannedReport )
+        return;
+    lastScannedReport = reports.back()->id;
+
     for (auto unit : df::global::world->units.all) {
         for ( int16_t b = df::enum_traits<df::unit_report_type>::first_item_value; b <= df::enum_traits<df::unit_report_type>::last_item_value; b++ ) {
             if ( b == df::unit_report_type::Sparring )
                 continue;
-            for ( size_t c = 0; c < unit->reports.log[b].size(); c++ ) {
-                int32_t report = unit->reports.log[b][c];
-                if ( std::find(reportToRelevantUnits[report].begin(), reportToRelevantUnits[report].end(), unit->id) != reportToRelevantUnits[report].end() )
-                    continue;
-                reportToRelevantUnits[unit->reports.log[b][c]].push_back(unit->id);
-            }
+            reportToRelevantUnits.scanLog(unit->id, unit->reports.log[b]);
         }
     }
+    reportToRelevantUnits.commit();
+}
+
+static void getRelevantUnits(int32_t reportId, std::vector<int32_t>& units) {
+    reportToRelevantUnits.getUnits(reportId, units);
+}
+
+// drop index entries that every active consumer has already processed; later
+// scans skip log entries at or below that point
+static void pruneReportToRelevantUnits() {
+    int32_t processed = std::numeric_limits<int32_t>::max();
+    if ( !handlers[EventType::UNIT_ATTACK].empty() )
+        processed = std::min(processed, lastReportUnitAttack);
+    if ( !handlers[EventType::INTERACTION].empty() )
+        processed = std::min(processed, lastReportInteraction);
+    reportToRelevantUnits.prune(processed);
 }
 
 static void manageReportEvent(color_ostream& out) {
@@ -1009,9 +1054,9 @@ static void manageReportEvent(color_ostream& out) {
 
     for ( ; idx < reports.size(); idx++ ) {
         df::report* report = reports[idx];
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for report event\n");
-            handle.eventHandler(out, (void*)intptr_t(report->id));
+            invokeHandler(out, EventType::REPORT, plugin, handle, (void*)intptr_t(report->id));
         }
         lastReport = report->id;
     }
@@ -1047,10 +1092,13 @@ static void manageUnitAttackEvent(color_ostream& out) {
         }
     }
 
-    if ( strikeReports.empty() )
+    if ( strikeReports.empty() ) {
+        pruneReportToRelevantUnits();
         return;
+    }
     updateReportToRelevantUnits();
     unordered_set<std::pair<int32_t, int32_t>, hash_pair> already_done;
+    std::vector<int32_t> relevantUnits;
     for (int reportId : strikeReports) {
         df::report* report = df::report::find(reportId);
         if ( !report )
@@ -1067,7 +1115,7 @@ static void manageUnitAttackEvent(color_ostream& out) {
             reportStr += report2->text;
         }
 
-        std::vector<int32_t>& relevantUnits = reportToRelevantUnits[report->id];
+        getRelevantUnits(report->id, relevantUnits);
         if ( relevantUnits.size() != 2 ) {
             continue;
         }
@@ -1086,9 +1134,9 @@ static void manageUnitAttackEvent(color_ostream& out) {
             data.wound = wound1->id;
 
             already_done.emplace(unit1->id, unit2->id);
-            for (auto &[_,handle] : copy) {
+            for (auto &[plugin,handle] : copy) {
                 DEBUG(log,out).print("calling handler for unit1 attack unit attack event\n");
-                handle.eventHandler(out, (void*)&data);
+                invokeHandler(out, EventType::UNIT_ATTACK, plugin, handle, (void*)&data);
             }
         }
 
@@ -1098,9 +1146,9 @@ static void manageUnitAttackEvent(color_ostream& out) {
             data.wound = wound2->id;
 
             already_done.emplace(unit1->id, unit2->id);
-            for (auto &[_,handle] : copy) {
+            for (auto &[plugin,handle] : copy) {
                 DEBUG(log,out).print("calling handler for unit2 attack unit attack event\n");
-                handle.eventHandler(out, (void*)&data);
+                invokeHandler(out, EventType::UNIT_ATTACK, plugin, handle, (void*)&data);
             }
         }
 
@@ -1110,9 +1158,9 @@ static void manageUnitAttackEvent(color_ostream& out) {
             data.wound = -1;
 
             already_done.emplace(unit1->id, unit2->id);
-            for (auto &[_,handle] : copy) {
+            for (auto &[plugin,handle] : copy) {
                 DEBUG(log,out).print("calling handler for unit1 killed unit attack event\n");
-                handle.eventHandler(out, (void*)&data);
+                invokeHandler(out, EventType::UNIT_ATTACK, plugin, handle, (void*)&data);
             }
         }
 
@@ -1122,9 +1170,9 @@ static void manageUnitAttackEvent(color_ostream& out) {
             data.wound = -1;
 
             already_done.emplace(unit1->id, unit2->id);
-            for (auto &[_,handle] : copy) {
+            for (auto &[plugin,handle] : copy) {
                 DEBUG(log,out).print("calling handler for unit2 killed unit attack event\n");
-                handle.eventHandler(out, (void*)&data);
+                invokeHandler(out, EventType::UNIT_ATTACK, plugin, handle, (void*)&data);
             }
         }
 
@@ -1294,10 +1342,11 @@ static vector<df::unit*> gatherRelevantUnits(color_ostream& out, df::report* r1,
     if ( r2 ) reports.push_back(r2);
     vector<df::unit*> result;
     unordered_set<int32_t> ids;
+    vector<int32_t> units;
 //out.print("%s,%d\n",__FILE__,__LINE__);
     for (auto report : reports) {
 //out.print("%s,%d\n",__FILE__,__LINE__);
-        vector<int32_t>& units = reportToRelevantUnits[report->id];
+        getRelevantUnits(report->id, units);
         if ( units.size() > 2 ) {
             if ( Once::doOnce("EventManager interaction too many relevant units") ) {
                 out.print("%s,%d: too many relevant units. On report\n \'%s\'\n", __FILE__, __LINE__, report->text.c_str());
@@ -1380,10 +1429,11 @@ static void manageInteractionEvent(color_ostream& out) {
         lastAttacker = df::unit::find(data.attacker);
         //lastDefender = df::unit::find(data.defender);
         //fire event
-        for (auto &[_,handle] : copy) {
+        for (auto &[plugin,handle] : copy) {
             DEBUG(log,out).print("calling handler for interaction event\n");
-            handle.eventHandler(out, (void*)&data);
+            invokeHandler(out, EventType::INTERACTION, plugin, handle, (void*)&data);
         }
         //TODO: deduce attacker from latest defend event first
     }
+    pruneReportToRelevantUnits();
 }
@@ -0,0 +1,404 @@
+#include "modules/EventManager.h"
+
+#include "EventManagerInternal.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace DFHack;
+using EventManager::EventHandler;
+using EventManager::TickHandle;
+using EventManager::Internal::ReportUnitIndex;
+using EventManager::Internal::TickWheel;
+
+namespace {
+
+std::vector<int32_t> unitsFor(const ReportUnitIndex &index, int32_t report_id) {
+    std::vector<int32_t> units;
+    index.getUnits(report_id, units);
+    return units;
+}
+
+TEST(ReportUnitIndex, indexesReportsFromEveryLog) {
+    ReportUnitIndex index;
+    index.scanLog(7, {1, 3});
+    index.scanLog(2, {3});
+    index.scanLog(2, {0, 3});
+    index.commit();
+
+    EXPECT_EQ(std::vector<int32_t>({2}), unitsFor(index, 0));
+    EXPECT_EQ(std::vector<int32_t>({7}), unitsFor(index, 1));
+    EXPECT_EQ(std::vector<int32_t>({2, 7}), unitsFor(index, 3));
+    EXPECT_TRUE(unitsFor(index, 2).empty());
+    EXPECT_EQ(4u, index.size());
+}
+
+TEST(ReportUnitIndex, rescanOnlyAddsNewEntries) {
+    ReportUnitIndex index;
+    std::vector<int32_t> log = {1, 2};
+    index.scanLog(1, log);
+    index.commit();
+    index.scanLog(1, log);
+    index.commit();
+    EXPECT_EQ(2u, index.size());
+
+    log.push_back(5);
+    index.scanLog(1, log);
+    index.commit();
+    EXPECT_EQ(std::vector<int32_t>({1}), unitsFor(index, 5));
+    EXPECT_EQ(3u, index.size());
+}
+
+TEST(ReportUnitIndex, indexesOlderReportAppendedLater) {
+    ReportUnitIndex index;
+    std::vector<int32_t> attacker = {10, 20};
+    std::vector<int32_t> defender = {5};
+    index.scanLog(1, attacker);
+    index.scanLog(2, defender);
+    index.commit();
+
+    // report 10 only reaches the defender's log after report 20 was indexed
+    defender.push_back(10);
+    index.scanLog(1, attacker);
+    index.scanLog(2, defender);
+    index.commit();
+
+    EXPECT_EQ(std::vector<int32_t>({1, 2}), unitsFor(index, 10));
+    EXPECT_EQ(std::vector<int32_t>({1}), unitsFor(index, 20));
+    EXPECT_EQ(4u, index.size());
+}
+
+TEST(ReportUnitIndex, ignoresReportsAlreadyProcessed) {
+    ReportUnitIndex index;
+    std::vector<int32_t> log = {4, 8};
+    index.scanLog(1, log);
+    index.commit();
+    index.prune(8);
+    EXPECT_EQ(0u, index.size());
+
+    // every consumer is past report 6, so appending it late doesn't matter
+    std::vector<int32_t> other = {6, 9};
+    index.scanLog(1, log);
+    index.scanLog(2, other);
+    index.commit();
+    EXPECT_TRUE(unitsFor(index, 6).empty());
+    EXPECT_EQ(std::vector<int32_t>({2}), unitsFor(index, 9));
+    EXPECT_EQ(1u, index.size());
+}
+
+TEST(ReportUnitIndex, clearReindexesPrunedReports) {
+    ReportUnitIndex index;
+    std::vector<int32_t> log = {1, 2, 3};
+    index.scanLog(1, log);
+    index.commit();
+
+    index.prune(2);
+    EXPECT_TRUE(unitsFor(index, 1).empty());
+    EXPECT_EQ(std::vector<int32_t>({1}), unitsFor(index, 3));
+
+    // pruned entries stay gone on a plain rescan, but come back after a reset
+    index.scanLog(1, log);
+    index.commit();
+    EXPECT_TRUE(unitsFor(index, 1).empty());
+
+    index.clear();
+    index.scanLog(1, log);
+    index.commit();
+    EXPECT_EQ(std::vector<int32_t>({1}), unitsFor(index, 1));
+    EXPECT_EQ(3u, index.size());
+}
+
+// TickWheel tests tag each timer through the handler's freq field
+
+EventHandler tagged(int32_t tag) {
+    return EventHandler(nullptr, tag);
+}
+
+Plugin *fakePlugin(intptr_t n) {
+    return reinterpret_cast<Plugin *>(n);
+}
+
+std::vector<int32_t> fireTo(TickWheel &wheel, int32_t tick) {
+    std::vector<int32_t> fired;
+    wheel.fire(tick, [&](Plugin *, const EventHandler &handler) {
+        fired.push_back(handler.freq);
+    });
+    return fired;
+}
+
+// advances the wheel one tick at a time from `from` to `to`, recording the tick
+// each timer fired on. `from` must already have been fired
+std::vector<std::pair<int32_t, int32_t>> stepTo(TickWheel &wheel, int32_t from, int32_t to) {
+    std::vector<std::pair<int32_t, int32_t>> fired;
+    for (int32_t tick = from + 1; tick <= to; tick++) {
+        for (int32_t tag : fireTo(wheel, tick))
+            fired.emplace_back(tag, tick);
+    }
+    return fired;
+}
+
+// advances the wheel in root-sized strides, which cascades every level but
+// never takes the rebase path. returns the last tick fired
+int32_t strideTo(TickWheel &wheel, int32_t from, int32_t to, std::vector<int32_t> &fired) {
+    while (from + 256 < to) {
+        from += 256;
+        for (int32_t tag : fireTo(wheel, from))
+            fired.push_back(tag);
+    }
+    return from;
+}
+
+TEST(TickWheel, firesOnScheduledTick) {
+    TickWheel wheel;
+    wheel.schedule(tagged(1), 5, nullptr);
+    EXPECT_EQ(1u, wheel.size());
+    EXPECT_TRUE(fireTo(wheel, 4).empty());
+    EXPECT_EQ(std::vector<int32_t>({1}), fireTo(wheel, 5));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TickWheel, cascadesAtLevelBoundaries) {
+    for (int32_t boundary : {1 << 8, 1 << 14, 1 << 20}) {
+        SCOPED_TRACE(boundary);
+        TickWheel wheel;
+        fireTo(wheel, 0);
+        wheel.schedule(tagged(boundary - 1), boundary - 1, nullptr);
+        wheel.schedule(tagged(boundary), boundary, nullptr);
+        wheel.schedule(tagged(boundary + 1), boundary + 1, nullptr);
+        wheel.schedule(tagged(2 * boundary + 3), 2 * boundary + 3, nullptr);
+
+        std::vector<int32_t> early;
+        int32_t tick = strideTo(wheel, 0, boundary - 2, early);
+        EXPECT_TRUE(early.empty());
+        auto fired = stepTo(wheel, tick, boundary + 1);
+        ASSERT_EQ(3u, fired.size());
+        for (auto &[tag, at] : fired)
+            EXPECT_EQ(tag, at);
+
+        tick = strideTo(wheel, boundary + 1, 2 * boundary + 2, early);
+        EXPECT_TRUE(early.empty());
+        fired = stepTo(wheel, tick, 2 * boundary + 3);
+        ASSERT_EQ(1u, fired.size());
+        EXPECT_EQ(2 * boundary + 3, fired[0].second);
+        EXPECT_TRUE(wheel.empty());
+    }
+}
+
+TEST(TickWheel, overflowTimersWaitForTheirTick) {
+    const int32_t far = (1 << 26) + 5;
+    TickWheel wheel;
+    fireTo(wheel, 0);
+    wheel.schedule(tagged(1), far, nullptr);
+    wheel.schedule(tagged(2), far + (1 << 26), nullptr);
+
+    std::vector<int32_t> early;
+    int32_t tick = strideTo(wheel, 0, far - 1, early);
+    EXPECT_TRUE(early.empty());
+    auto fired = stepTo(wheel, tick, far);
+    ASSERT_EQ(1u, fired.size());
+    EXPECT_EQ(std::make_pair(1, far), fired[0]);
+    EXPECT_EQ(1u, wheel.size());
+
+    // a jump straight to the tick refiles the remaining overflow timer
+    EXPECT_TRUE(fireTo(wheel, far + (1 << 26) - 1).empty());
+    EXPECT_EQ(std::vector<int32_t>({2}), fireTo(wheel, far + (1 << 26)));
+}
+
+TEST(TickWheel, rebaseAfterLongGap) {
+    TickWheel wheel;
+    fireTo(wheel, 0);
+    wheel.schedule(tagged(300), 300, nullptr);
+    wheel.schedule(tagged(10), 10, nullptr);
+    wheel.schedule(tagged(5000), 5000, nullptr);
+    wheel.schedule(tagged(20000), 20000, nullptr);
+
+    EXPECT_EQ(std::vector<int32_t>({10, 300}), fireTo(wheel, 4000));
+    auto fired = stepTo(wheel, 4000, 5000);
+    ASSERT_EQ(1u, fired.size());
+    EXPECT_EQ(std::make_pair(5000, 5000), fired[0]);
+    EXPECT_TRUE(fireTo(wheel, 19999).empty());
+    EXPECT_EQ(std::vector<int32_t>({20000}), fireTo(wheel, 20000));
+}
+
+TEST(TickWheel, overdueTimersRunFirstInTickOrder) {
+    TickWheel wheel;
+    fireTo(wheel, 99);
+    wheel.schedule(tagged(100), 100, nullptr);
+    wheel.schedule(tagged(50), 50, nullptr);
+    wheel.schedule(tagged(20), 20, nullptr);
+    wheel.schedule(tagged(51), 50, nullptr);
+    EXPECT_EQ(std::vector<int32_t>({20, 50, 51, 100}), fireTo(wheel, 100));
+}
+
+TEST(TickWheel, handlerSchedulesForCurrentTick) {
+    TickWheel wheel;
+    fireTo(wheel, 9);
+    wheel.schedule(tagged(1), 10, nullptr);
+    wheel.schedule(tagged(2), 10, nullptr);
+
+    std::vector<int32_t> fired;
+    wheel.fire(10, [&](Plugin *, const EventHandler &handler) {
+        fired.push_back(handler.freq);
+        if (handler.freq == 1) {
+            wheel.schedule(tagged(3), 10, nullptr); // after the other timer for this tick
+            wheel.schedule(tagged(4), 9, nullptr);  // overdue, so next
+            wheel.schedule(tagged(5), 11, nullptr); // not yet
+        }
+    });
+    EXPECT_EQ(std::vector<int32_t>({1, 4, 2, 3}), fired);
+    EXPECT_EQ(std::vector<int32_t>({5}), fireTo(wheel, 11));
+}
+
+TEST(TickWheel, cancelByHandle) {
+    TickWheel wheel;
+    fireTo(wheel, 0);
+    EXPECT_FALSE(wheel.cancel(0));
+
+    TickHandle cancelled = wheel.schedule(tagged(1), 5, nullptr);
+    EXPECT_TRUE(wheel.cancel(cancelled));
+    EXPECT_FALSE(wheel.cancel(cancelled));
+    EXPECT_TRUE(fireTo(wheel, 5).empty());
+
+    // the slab entry is reused, but the old handle stays dead
+    TickHandle fired = wheel.schedule(tagged(2), 6, nullptr);
+    EXPECT_EQ(std::vector<int32_t>({2}), fireTo(wheel, 6));
+    EXPECT_FALSE(wheel.cancel(fired));
+    TickHandle reused = wheel.schedule(tagged(3), 7, nullptr);
+    EXPECT_EQ(fired & 0xffffffff, reused & 0xffffffff);
+    EXPECT_FALSE(wheel.cancel(cancelled));
+    EXPECT_FALSE(wheel.cancel(fired));
+    EXPECT_TRUE(wheel.cancel(reused));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TickWheel, clearInvalidatesHandles) {
+    TickWheel wheel;
+    TickHandle a = wheel.schedule(tagged(1), 5, fakePlugin(1));
+    TickHandle b = wheel.schedule(tagged(2), 500, fakePlugin(2));
+    wheel.clear();
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_TRUE(wheel.getPluginCounts().empty());
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(b));
+
+    TickHandle c = wheel.schedule(tagged(3), 5, nullptr);
+    TickHandle d = wheel.schedule(tagged(4), 5, nullptr);
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_TRUE(wheel.cancel(c));
+    EXPECT_EQ(std::vector<int32_t>({4}), fireTo(wheel, 5));
+    EXPECT_FALSE(wheel.cancel(d));
+}
+
+TEST(TickWheel, cancelByPlugin) {
+    TickWheel wheel;
+    wheel.schedule(EventHandler(nullptr, 1), 5, fakePlugin(1));
+    wheel.schedule(EventHandler(nullptr, 2), 5, fakePlugin(1));
+    wheel.schedule(EventHandler(nullptr, 1), 5, fakePlugin(2));
+    wheel.schedule(EventHandler(nullptr, 3), 600, fakePlugin(2));
+    EXPECT_EQ(2u, wheel.getPluginCounts()[fakePlugin(2)]);
+
+    wheel.cancel(fakePlugin(1), EventHandler(nullptr, 1));
+    wheel.cancelAll(fakePlugin(2));
+    EXPECT_EQ(1u, wheel.size());
+    EXPECT_EQ(std::vector<int32_t>({2}), fireTo(wheel, 1000));
+}
+
+// The wheel replaced a multimap keyed by tick: callbacks ran by tick, and in
+// scheduling order within a tick, with whatever they scheduled for a tick that
+// was already due running in the same pass.
+class TickQueueModel {
+public:
+    void schedule(int32_t tag, int32_t when) {
+        entries[tag] = queue.emplace(when, tag);
+    }
+    bool cancel(int32_t tag) {
+        auto it = entries.find(tag);
+        if (it == entries.end())
+            return false;
+        queue.erase(it->second);
+        entries.erase(it);
+        return true;
+    }
+    template<typename Fn>
+    void fire(int32_t tick, Fn &&invoke) {
+        while (!queue.empty() && queue.begin()->first <= tick) {
+            int32_t tag = queue.begin()->second;
+            entries.erase(tag);
+            queue.erase(queue.begin());
+            invoke(tag);
+        }
+    }
+private:
+    std::multimap<int32_t, int32_t> queue;
+    std::map<int32_t, std::multimap<int32_t, int32_t>::iterator> entries;
+};
+
+TEST(TickWheel, matchesMultimapOrder) {
+    std::mt19937 rng(12345);
+    auto chance = [&](int percent) { return int(rng() % 100) < percent; };
+    auto delay = [&]() -> int32_t {
+        switch (rng() % 6) {
+        case 0: return -int32_t(rng() % 50);     // overdue
+        case 1: return 0;                        // current tick
+        case 2: return rng() % 8;                // collisions likely
+        case 3: return rng() % 1024;
+        case 4: return rng() % (1 << 15);
+        default: return 200 + rng() % 400;
+        }
+    };
+
+    TickWheel wheel;
+    TickQueueModel model;
+    std::map<int32_t, TickHandle> handles;
+    std::vector<int32_t> wheel_fired, model_fired;
+    int32_t next_tag = 1;
+    int32_t tick = 0;
+
+    // some callbacks schedule a follow-up for the tick being fired or an
+    // earlier one. follow-ups get negative tags and don't schedule again
+    auto follow_up = [&](int32_t tag, auto &&schedule) {
+        if (tag > 0 && tag % 5 == 0)
+            schedule(-tag, tick - tag % 3);
+    };
+
+    while (tick < (1 << 16)) {
+        for (int n = rng() % 4; n > 0; n--) {
+            int32_t tag = next_tag++;
+            int32_t when = tick + delay();
+            handles[tag] = wheel.schedule(tagged(tag), when, nullptr);
+            model.schedule(tag, when);
+        }
+        if (chance(10) && !handles.empty()) {
+            auto it = std::next(handles.begin(), rng() % handles.size());
+            EXPECT_EQ(model.cancel(it->first), wheel.cancel(it->second));
+            handles.erase(it);
+        }
+
+        // mostly single ticks, with the odd jump long enough to rebase
+        tick += chance(1) ? 300 + rng() % 2000 : 1;
+
+        wheel.fire(tick, [&](Plugin *, const EventHandler &handler) {
+            wheel_fired.push_back(handler.freq);
+            handles.erase(handler.freq);
+            follow_up(handler.freq, [&](int32_t tag, int32_t when) {
+                wheel.schedule(tagged(tag), when, nullptr);
+            });
+        });
+        model.fire(tick, [&](int32_t tag) {
+            model_fired.push_back(tag);
+            follow_up(tag, [&](int32_t tag, int32_t when) {
+                model.schedule(tag, when);
+            });
+        });
+        ASSERT_EQ(model_fired, wheel_fired) << "at tick " << tick;
+    }
+    EXPECT_GT(wheel_fired.size(), 5000u);
+}
+
+} // namespace
@@ -0,0 +1,394 @@
+#pragma once
+
+// Data structures behind EventManager that are not part of its public API.
+// They live here, rather than in EventManager.cpp, so that unit tests can
+// exercise them directly.
+
+#include "modules/EventManager.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DFHack {
+namespace EventManager {
+namespace Internal {
+
+/*
+ * Hierarchical timing wheel holding one-shot TICK callbacks, in the style of
+ * the classic Linux kernel timer wheel. The root level has one slot per tick
+ * for the next ROOT_SIZE ticks; each coarser level covers LEVEL_SIZE times the
+ * range of the one below it, and its slots are cascaded down as they come into
+ * range. Timers live in a reusable slab and are threaded onto intrusive
+ * per-slot and per-plugin lists, so scheduling and cancelling are O(1) and a
+ * steady state of re-registered timers does not allocate.
+ *
+ * Callbacks fire in the same order as the multimap this replaced: by
+ * scheduled tick, and in scheduling order within a tick. Timers that are
+ * scheduled for a tick that has already been processed are overdue and run
+ * before anything else, oldest first.
+ **/
+class TickWheel {
+public:
+    TickWheel() {
+        clear();
+    }
+
+    bool empty() const { return depth == 0; }
+    size_t size() const { return depth; }
+
+    // when the wheel is empty, it can be moved to any point in time
+    void rewind(int32_t tick) {
+        if (empty())
+            nextTick = tick;
+    }
+
+    TickHandle schedule(const EventHandler &handler, int32_t when, Plugin *plugin) {
+        int32_t idx;
+        if (freeList != NIL) {
+            idx = freeList;
+            freeList = timers[idx].next;
+            timers[idx].handler = handler;
+            timers[idx].plugin = plugin;
+            timers[idx].when = when;
+        } else {
+            idx = (int32_t)timers.size();
+            timers.push_back(Timer{handler, plugin, when, 1, NIL, NIL, NIL, NIL, NIL});
+        }
+        Timer &timer = timers[idx];
+
+        PluginTimers &owner = pluginTimers[plugin];
+        timer.plugin_prev = NIL;
+        timer.plugin_next = owner.head;
+        if (owner.head != NIL)
+            timers[owner.head].plugin_prev = idx;
+        owner.head = idx;
+        ++owner.count;
+        ++depth;
+
+        link(idx, false);
+        return (TickHandle(timer.generation) << 32) | TickHandle(idx + 1);
+    }
+
+    bool cancel(TickHandle handle) {
+        int64_t idx = int64_t(handle & 0xffffffff) - 1;
+        if (idx < 0 || idx >= (int64_t)timers.size())
+            return false;
+        Timer &timer = timers[idx];
+        if (timer.slot == NIL || timer.generation != uint32_t(handle >> 32))
+            return false;
+        release((int32_t)idx);
+        return true;
+    }
+
+    // cancels the plugin's timers that match handler, whose freq holds the tick it was scheduled for
+    void cancel(Plugin *plugin, const EventHandler &handler) {
+        auto it = pluginTimers.find(plugin);
+        if (it == pluginTimers.end())
+            return;
+        for (int32_t idx = it->second.head; idx != NIL; ) {
+            int32_t next = timers[idx].plugin_next;
+            if (timers[idx].handler == handler)
+                release(idx);
+            idx = next;
+        }
+    }
+
+    void cancelAll(Plugin *plugin) {
+        auto it = pluginTimers.find(plugin);
+        if (it == pluginTimers.end())
+            return;
+        while (it->second.head != NIL)
+            release(it->second.head);
+    }
+
+    void clear() {
+        // timers go back on the free list rather than being destroyed so that
+        // their generations survive and outstanding handles stay invalid
+        freeList = NIL;
+        for (int32_t idx = (int32_t)timers.size() - 1; idx >= 0; idx--) {
+            Timer &timer = timers[idx];
+            if (timer.slot != NIL) {
+                ++timer.generation;
+                timer.slot = NIL;
+            }
+            timer.next = freeList;
+            freeList = idx;
+        }
+        for (int32_t i = 0; i < NUM_SLOTS; i++)
+            slotHead[i] = slotTail[i] = NIL;
+        pluginTimers.clear();
+        depth = 0;
+        nextTick = 0;
+    }
+
+    std::map<Plugin*, size_t> getPluginCounts() const {
+        std::map<Plugin*, size_t> counts;
+        for (auto &[plugin, owner] : pluginTimers) {
+            if (owner.count)
+                counts.emplace(plugin, owner.count);
+        }
+        return counts;
+    }
+
+    // calls invoke(plugin, handler) for every callback scheduled for a tick up
+    // to and including the given one. callbacks may schedule or cancel timers;
+    // anything they schedule for a tick up to this one also runs in this call
+    template<typename Fn>
+    void fire(int32_t tick, Fn &&invoke) {
+        if (empty()) {
+            nextTick = tick + 1;
+            return;
+        }
+        // walking a long gap slot by slot would be wasteful; refile everything instead
+        if (int64_t(tick) - nextTick > ROOT_SIZE)
+            rebase(tick);
+
+        while (nextTick <= tick) {
+            int32_t idx = nextTick & (ROOT_SIZE - 1);
+            if (idx == 0)
+                cascadeLevels();
+            for (;;) {
+                int32_t t = slotHead[OVERDUE_SLOT];
+                if (t == NIL)
+                    t = slotHead[idx];
+                if (t == NIL)
+                    break;
+                EventHandler handler = timers[t].handler;
+                Plugin *plugin = timers[t].plugin;
+                // release first so the callback is free to schedule or cancel timers
+                release(t);
+                invoke(plugin, handler);
+            }
+            ++nextTick;
+        }
+    }
+
+private:
+    static const int32_t ROOT_BITS = 8;
+    static const int32_t LEVEL_BITS = 6;
+    static const int32_t NUM_LEVELS = 4; // the root level plus three coarser ones
+    static const int32_t ROOT_SIZE = 1 << ROOT_BITS;
+    static const int32_t LEVEL_SIZE = 1 << LEVEL_BITS;
+    // timers too far in the future for any level wait here until the top level wraps
+    static const int32_t OVERFLOW_SLOT = ROOT_SIZE + (NUM_LEVELS - 1) * LEVEL_SIZE;
+    // timers scheduled for ticks before nextTick, sorted by tick
+    static const int32_t OVERDUE_SLOT = OVERFLOW_SLOT + 1;
+    static const int32_t NUM_SLOTS = OVERDUE_SLOT + 1;
+    static const int32_t NIL = -1;
+
+    struct Timer {
+        EventHandler handler;
+        Plugin *plugin;
+        int32_t when;
+        uint32_t generation;
+        int32_t slot; // NIL while on the free list
+        int32_t prev, next; // slot list, or the free list (next only)
+        int32_t plugin_prev, plugin_next;
+    };
+
+    struct PluginTimers {
+        int32_t head = NIL;
+        size_t count = 0;
+    };
+
+    std::vector<Timer> timers;
+    int32_t freeList;
+    int32_t slotHead[NUM_SLOTS];
+    int32_t slotTail[NUM_SLOTS];
+    // entries are kept when their count drops to zero so plugins that keep
+    // re-registering a single timer don't churn the map
+    std::unordered_map<Plugin*, PluginTimers> pluginTimers;
+    size_t depth;
+    int32_t nextTick; // the next tick that fire() will process
+
+    int32_t slotFor(int32_t when) const {
+        int64_t delta = int64_t(when) - nextTick;
+        if (delta < 0)
+            return OVERDUE_SLOT;
+        if (delta < ROOT_SIZE)
+            return when & (ROOT_SIZE - 1);
+        int32_t base = ROOT_SIZE;
+        for (int32_t level = 1; level < NUM_LEVELS; level++) {
+            int32_t shift = ROOT_BITS + level * LEVEL_BITS;
+            if (delta < (int64_t(1) << shift))
+                return base + ((when >> (shift - LEVEL_BITS)) & (LEVEL_SIZE - 1));
+            base += LEVEL_SIZE;
+        }
+        return OVERFLOW_SLOT;
+    }
+
+    // files the timer in the slot for its tick. front is used when cascading:
+    // a timer that was waiting in a coarser level was scheduled before any
+    // timer for the same tick that went straight into a finer one
+    void link(int32_t idx, bool front) {
+        Timer &timer = timers[idx];
+        int32_t slot = slotFor(timer.when);
+        timer.slot = slot;
+        int32_t after = slotTail[slot];
+        if (slot == OVERDUE_SLOT) {
+            while (after != NIL && timers[after].when > timer.when)
+                after = timers[after].prev;
+        } else if (front) {
+            after = NIL;
+        }
+        timer.prev = after;
+        timer.next = after != NIL ? timers[after].next : slotHead[slot];
+        if (timer.prev != NIL)
+            timers[timer.prev].next = idx;
+        else
+            slotHead[slot] = idx;
+        if (timer.next != NIL)
+            timers[timer.next].prev = idx;
+        else
+            slotTail[slot] = idx;
+    }
+
+    void unlink(int32_t idx) {
+        Timer &timer = timers[idx];
+        if (timer.prev != NIL)
+            timers[timer.prev].next = timer.next;
+        else
+            slotHead[timer.slot] = timer.next;
+        if (timer.next != NIL)
+            timers[timer.next].prev = timer.prev;
+        else
+            slotTail[timer.slot] = timer.prev;
+    }
+
+    void release(int32_t idx) {
+        unlink(idx);
+        Timer &timer = timers[idx];
+        PluginTimers &owner = pluginTimers[timer.plugin];
+        if (timer.plugin_prev != NIL)
+            timers[timer.plugin_prev].plugin_next = timer.plugin_next;
+        else
+            owner.head = timer.plugin_next;
+        if (timer.plugin_next != NIL)
+            timers[timer.plugin_next].plugin_prev = timer.plugin_prev;
+        --owner.count;
+        --depth;
+
+        ++timer.generation;
+        timer.slot = NIL;
+        timer.next = freeList;
+        freeList = idx;
+    }
+
+    // refiles every timer in the slot relative to the current tick, ahead of
+    // the timers already in their new slots and in their existing order
+    void cascade(int32_t slot) {
+        int32_t idx = slotTail[slot];
+        slotHead[slot] = slotTail[slot] = NIL;
+        while (idx != NIL) {
+            int32_t prev = timers[idx].prev;
+            link(idx, true);
+            idx = prev;
+        }
+    }
+
+    // called whenever the root level wraps around. coarser levels are
+    // cascaded after finer ones, so they end up at the front of each slot
+    void cascadeLevels() {
+        int32_t base = ROOT_SIZE;
+        for (int32_t level = 1; level < NUM_LEVELS; level++) {
+            int32_t shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+            int32_t idx = (nextTick >> shift) & (LEVEL_SIZE - 1);
+            cascade(base + idx);
+            if (idx != 0)
+                return;
+            base += LEVEL_SIZE;
+        }
+        cascade(OVERFLOW_SLOT);
+    }
+
+    void rebase(int32_t tick) {
+        // gather coarsest slots first: for any given tick, timers in coarser
+        // levels were scheduled before those in finer ones
+        std::vector<int32_t> pending;
+        pending.reserve(depth);
+        for (int32_t slot = NUM_SLOTS - 1; slot >= 0; slot--) {
+            for (int32_t idx = slotHead[slot]; idx != NIL; idx = timers[idx].next)
+                pending.push_back(idx);
+            slotHead[slot] = slotTail[slot] = NIL;
+        }
+        std::stable_sort(pending.begin(), pending.end(), [&](int32_t a, int32_t b) {
+            return timers[a].when < timers[b].when;
+        });
+        nextTick = tick;
+        for (int32_t idx : pending)
+            link(idx, false);
+    }
+};
+
+/*
+ * Maps report ids to the units whose report logs contain them, for the
+ * UNIT_ATTACK and INTERACTION events. Entries are dropped once every consumer
+ * has processed their report, and that point also serves as the floor for
+ * scanning: a scan reads only the log entries above it, walking back from the
+ * end of each log. A report that reaches a unit's log after newer ones were
+ * indexed is still above the floor, so it is picked up on the next scan. The
+ * index keeps no per-unit state, so dead and departed units cost nothing.
+ **/
+class ReportUnitIndex {
+public:
+    // queues the entries of one unit log above the prune floor
+    void scanLog(int32_t unit_id, const std::vector<int32_t> &log) {
+        // logs are in report order, so only their tails can be above the floor
+        for (size_t c = log.size(); c > 0 && log[c-1] > floor; c--)
+            pending.emplace_back(log[c-1], unit_id);
+    }
+
+    // merges everything queued by scanLog into the index. entries that were
+    // already indexed by an earlier scan are dropped as duplicates
+    void commit() {
+        if (pending.empty())
+            return;
+        std::sort(pending.begin(), pending.end());
+        size_t old_size = entries.size();
+        entries.insert(entries.end(), pending.begin(), pending.end());
+        pending.clear();
+        std::inplace_merge(entries.begin(), entries.begin() + old_size, entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    }
+
+    // fills units with the (sorted) ids of the units that logged report_id
+    void getUnits(int32_t report_id, std::vector<int32_t> &units) const {
+        units.clear();
+        auto it = std::lower_bound(entries.begin(), entries.end(),
+                                   std::make_pair(report_id, std::numeric_limits<int32_t>::min()));
+        for ( ; it != entries.end() && it->first == report_id; ++it)
+            units.push_back(it->second);
+    }
+
+    // drops entries for reports with ids up to and including report_id, and
+    // stops later scans from reading them again
+    void prune(int32_t report_id) {
+        floor = std::max(floor, report_id);
+        while (!entries.empty() && entries.front().first <= floor)
+            entries.pop_front();
+    }
+
+    // forgets everything, so the next scan re-reads every log in full
+    void clear() {
+        entries.clear();
+        pending.clear();
+        floor = -1;
+    }
+
+    size_t size() const { return entries.size(); }
+
+private:
+    // sorted (report id, unit id) pairs
+    std::deque<std::pair<int32_t, int32_t>> entries;
+    std::vector<std::pair<int32_t, int32_t>> pending;
+    int32_t floor = -1;
+};
+
+}
+}
+}
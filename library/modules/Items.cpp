@@ -43,6 +43,7 @@ using namespace std;
 #include "modules/MapCache.h"
 #include "modules/Materials.h"
 #include "modules/Items.h"
+#include "modules/RawIndex.h"
 #include "modules/Units.h"
 
 #include "df/body_part_raw.h"
@@ -240,27 +241,16 @@ bool ItemTypeInfo::find(const std::string &token)
     if (items.size() == 1)
         return true;
 
-    df::world_raws::T_itemdefs &defs = df::global::world->raws.itemdefs;
-
-    switch (type) {
-#define ITEM(type,vec,tclass) \
-    case type: \
-        for (size_t i = 0; i < defs.vec.size(); i++) { \
-            if (defs.vec[i]->id == items[1]) { \
-                subtype = i; custom = defs.vec[i]; return true; \
-            } \
-        } \
-        break;
-ITEMDEF_VECTORS
-#undef ITEM
+    if (Items::getSubtypeCount(type) < 0)
+        return items[1] == "NONE";
 
-    default:
-        if (items[1] == "NONE")
-            return true;
-        break;
-    }
+    int16_t found = RawIndex::findItemSubtype(type, items[1]);
+    if (found < 0)
+        return false;
 
-    return (subtype >= 0);
+    subtype = found;
+    custom = Items::getSubtypeDef(type, subtype);
+    return true;
 }
 
 bool Items::isCasteMaterial(df::item_type itype)
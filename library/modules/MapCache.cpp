@@ -742,6 +742,7 @@ bool MapExtras::Block::Write ()
         COPY(block->designation, designation);
         block->flags.bits.designated = true;
         block->dsgn_check_cooldown = 0;
+        Maps::invalidateDesignationCensus(block);
         dirty_designations = false;
     }
     if(dirty_tiles || dirty_veins)
@@ -1206,7 +1207,9 @@ MapExtras::MapCache::MapCache()
     std::vector<std::vector<int16_t> > layer_mats;
     validgeo = Maps::ReadGeology(&layer_mats, &geoidx);
     valid = true;
+    block_levels.resize(z_max);
 
+    std::map<df::coord2d, df::world_region_details*> region_details;
     if (auto data = df::global::world->world_data)
     {
         for (size_t i = 0; i < data->region_details.size(); i++)
@@ -1256,6 +1259,22 @@ MapExtras::MapCache::MapCache()
     }
 }
 
+template<typename F>
+void MapExtras::MapCache::forEachBlock(F fn)
+{
+    size_t level_size = size_t(x_bmax) * y_bmax;
+    for (auto &level : block_levels)
+    {
+        if (!level)
+            continue;
+        for (size_t i = 0; i < level_size; i++)
+        {
+            if (level[i])
+                fn(level[i]);
+        }
+    }
+}
+
 bool MapExtras::MapCache::WriteAll()
 {
     auto world = df::global::world;
@@ -1266,11 +1285,10 @@ bool MapExtras::MapCache::WriteAll()
         df::job* job = job_link->item;
         df::coord pos = job->pos;
         df::coord blockpos(pos.x>>4,pos.y>>4,pos.z);
-        auto iter = blocks.find(blockpos);
-        if (iter == blocks.end())
+        auto block = findBlock(blockpos);
+        if (!block)
             continue;
         df::coord2d bpos(pos.x - (blockpos.x<<4),pos.y - (blockpos.y<<4));
-        auto block = iter->second;
         if (!block->designated_tiles.test(bpos.x+bpos.y*16))
             continue;
         bool is_designed = ENUM_ATTR(job_type,is_designation,job->job_type);
@@ -1280,48 +1298,79 @@ bool MapExtras::MapCache::WriteAll()
         // processing.
         Job::removeJob(job);
     }
-    std::map<DFCoord, Block *>::iterator p;
-    for(p = blocks.begin(); p != blocks.end(); p++)
+    forEachBlock([](Block *block) { block->Write(); });
+    return true;
+}
+
+MapExtras::Block *MapExtras::MapCache::findBlock(DFCoord blockcoord)
+{
+    if(unsigned(blockcoord.x) >= x_bmax ||
+       unsigned(blockcoord.y) >= y_bmax ||
+       unsigned(blockcoord.z) >= z_max)
+        return NULL;
+
+    auto &level = block_levels[blockcoord.z];
+    return level ? level[blockcoord.x + blockcoord.y * x_bmax] : NULL;
+}
+
+MapExtras::Block *MapExtras::MapCache::newBlock(DFCoord blockcoord)
+{
+    if (free_blocks.empty())
     {
-        p->second->Write();
+        auto chunk = new BlockStorage[BLOCK_POOL_CHUNK];
+        block_pool.emplace_back(chunk);
+        for (size_t i = BLOCK_POOL_CHUNK; i > 0; i--)
+            free_blocks.push_back(&chunk[i-1]);
     }
-    return true;
+
+    auto storage = free_blocks.back();
+    free_blocks.pop_back();
+    return new (storage) Block(this, blockcoord);
+}
+
+void MapExtras::MapCache::deleteBlock(Block *block)
+{
+    block->~Block();
+    free_blocks.push_back(reinterpret_cast<BlockStorage *>(block));
 }
 
 MapExtras::Block *MapExtras::MapCache::BlockAt(DFCoord blockcoord)
 {
     if(!valid)
         return 0;
-    std::map <DFCoord, Block*>::iterator iter = blocks.find(blockcoord);
-    if(iter != blocks.end())
-    {
-        return (*iter).second;
-    }
-    else
-    {
-        if(unsigned(blockcoord.x) < x_bmax &&
-           unsigned(blockcoord.y) < y_bmax &&
-           unsigned(blockcoord.z) < z_max)
-        {
-            Block * nblo = new Block(this, blockcoord);
-            blocks[blockcoord] = nblo;
-            return nblo;
-        }
+    if(unsigned(blockcoord.x) >= x_bmax ||
+       unsigned(blockcoord.y) >= y_bmax ||
+       unsigned(blockcoord.z) >= z_max)
         return 0;
-    }
+
+    auto &level = block_levels[blockcoord.z];
+    if (!level)
+        level.reset(new Block *[size_t(x_bmax) * y_bmax]());
+
+    Block *&slot = level[blockcoord.x + blockcoord.y * x_bmax];
+    if (!slot)
+        slot = newBlock(blockcoord);
+    return slot;
 }
 
 void MapExtras::MapCache::discardBlock(Block *block)
 {
-    blocks.erase(block->bcoord);
-    delete block;
+    auto &level = block_levels[block->bcoord.z];
+    level[block->bcoord.x + block->bcoord.y * x_bmax] = NULL;
+    deleteBlock(block);
 }
 
 void MapExtras::MapCache::resetTags()
 {
-    for (auto it = blocks.begin(); it != blocks.end(); ++it)
-    {
-        delete[] it->second->tags;
-        it->second->tags = NULL;
-    }
+    forEachBlock([](Block *block) {
+        delete[] block->tags;
+        block->tags = NULL;
+    });
+}
+
+void MapExtras::MapCache::trash()
+{
+    forEachBlock([this](Block *block) { deleteBlock(block); });
+    for (auto &level : block_levels)
+        level.reset();
 }
@@ -25,10 +25,17 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <cstdlib>
 #include <iostream>
 using namespace std;
@@ -40,6 +47,7 @@ using namespace std;
 #include "MemAccess.h"
 #include "MiscUtils.h"
 #include "ModuleFactory.h"
+#include "PerfCounters.h"
 #include "VersionInfo.h"
 
 #include "modules/Buildings.h"
@@ -257,6 +265,201 @@ df::map_block *Maps::ensureTileBlock (int32_t x, int32_t y, int32_t z)
     return slot;
 }
 
+size_t Maps::getParallelWorkerCount()
+{
+    static const size_t count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16);
+    return count;
+}
+
+void Maps::parallelForEachBlock(const std::function<void(df::map_block *block, size_t worker)> &fn)
+{
+    // blocks are handed out in chunks so workers rarely contend on the
+    // shared cursor, but small enough that uneven blocks still balance out
+    static constexpr size_t CHUNK = 64;
+    static auto &hist = PerfCounters::get("maps/parallelForEachBlock");
+
+    PerfTimer timer(hist);
+    auto &blocks = world->map.map_blocks;
+    size_t num_blocks = blocks.size();
+    size_t num_workers = std::min(getParallelWorkerCount(), (num_blocks + CHUNK - 1) / CHUNK);
+
+    if (num_workers <= 1)
+    {
+        for (auto block : blocks)
+            if (block)
+                fn(block, 0);
+        return;
+    }
+
+    std::atomic<size_t> cursor(0);
+    std::atomic<bool> failed(false);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto work = [&](size_t worker) {
+        try
+        {
+            size_t start;
+            while (!failed.load(std::memory_order_relaxed) &&
+                    (start = cursor.fetch_add(CHUNK, std::memory_order_relaxed)) < num_blocks)
+            {
+                size_t end = std::min(start + CHUNK, num_blocks);
+                for (size_t i = start; i < end; i++)
+                    if (auto block = blocks[i])
+                        fn(block, worker);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < num_workers; worker++)
+    {
+        try
+        {
+            threads.emplace_back(work, worker);
+        }
+        catch (const std::system_error &)
+        {
+            // out of threads; the ones we have will cover the rest
+            break;
+        }
+    }
+
+    work(0);
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/*
+ * Designation census
+ */
+
+// per-block counts and fortress totals, rebuilt at most once per Core update;
+// blocks DFHack itself changes in between are recounted individually
+static std::unordered_map<df::map_block *, Maps::DesignationCounts> census;
+static Maps::DesignationCounts census_totals;
+static uint32_t census_update = 0;
+static std::vector<df::map_block *> census_dirty;
+
+static void add_counts(Maps::DesignationCounts &to, const Maps::DesignationCounts &from, int sign)
+{
+    to.dig += sign * from.dig;
+    to.marked += sign * from.marked;
+    to.smooth += sign * from.smooth;
+    to.track += sign * from.track;
+}
+
+static Maps::DesignationCounts count_designations(df::map_block *block)
+{
+    Maps::DesignationCounts counts;
+    for (int x = 0; x < 16; x++)
+    {
+        for (int y = 0; y < 16; y++)
+        {
+            auto &td = block->designation[x][y];
+            auto &to = block->occupancy[x][y];
+            if (td.bits.dig != tile_dig_designation::No)
+            {
+                if (to.bits.dig_marked)
+                    counts.marked++;
+                else
+                    counts.dig++;
+            }
+            if (td.bits.smooth)
+                counts.smooth++;
+            if (to.bits.carve_track_north || to.bits.carve_track_south ||
+                    to.bits.carve_track_east || to.bits.carve_track_west)
+                counts.track++;
+        }
+    }
+    return counts;
+}
+
+static void recount_block(df::map_block *block)
+{
+    auto it = census.find(block);
+    if (it != census.end())
+    {
+        add_counts(census_totals, it->second, -1);
+        census.erase(it);
+    }
+    if (!block->flags.bits.designated)
+        return;
+    auto counts = count_designations(block);
+    if (!counts.total())
+        return;
+    add_counts(census_totals, counts, 1);
+    census.emplace(block, counts);
+}
+
+static void refresh_census()
+{
+    static auto &hist = PerfCounters::get("maps/designationCensus");
+    static auto &dirty_recounts = PerfCounters::getCounter("maps/designationCensus/dirty");
+
+    uint32_t update = Core::getInstance().getUpdateCount();
+    if (census_update == update)
+    {
+        for (auto block : census_dirty)
+        {
+            dirty_recounts.add();
+            recount_block(block);
+        }
+        census_dirty.clear();
+        return;
+    }
+
+    PerfTimer timer(hist);
+
+    census.clear();
+    census_dirty.clear();
+    census_totals = Maps::DesignationCounts();
+    for (auto block : world->map.map_blocks)
+    {
+        if (block && block->flags.bits.designated)
+            recount_block(block);
+    }
+    census_update = update;
+}
+
+const Maps::DesignationCounts &Maps::getDesignationCounts()
+{
+    refresh_census();
+    return census_totals;
+}
+
+void Maps::forEachDesignatedBlock(const std::function<void(df::map_block *block, const DesignationCounts &counts)> &fn)
+{
+    refresh_census();
+    for (auto &[block, counts] : census)
+        fn(block, counts);
+}
+
+void Maps::invalidateDesignationCensus(df::map_block *block)
+{
+    // a census from an earlier update is rebuilt wholesale on the next query
+    if (block && census_update == Core::getInstance().getUpdateCount())
+        census_dirty.push_back(block);
+}
+
+void Maps::resetDesignationCensus()
+{
+    census.clear();
+    census_dirty.clear();
+    census_totals = DesignationCounts();
+    census_update = 0;
+}
+
 df::tiletype *Maps::getTileType(int32_t x, int32_t y, int32_t z)
 {
     df::map_block *block = getTileBlock(x,y,z);
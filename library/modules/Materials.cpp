@@ -33,6 +33,7 @@ using namespace std;
 
 #include "Types.h"
 #include "modules/Materials.h"
+#include "modules/RawIndex.h"
 #include "VersionInfo.h"
 #include "MemAccess.h"
 #include "Error.h"
@@ -238,13 +239,9 @@ bool MaterialInfo::findInorganic(const std::string &token)
         return true;
     }
 
-    df::world_raws &raws = world->raws;
-    for (size_t i = 0; i < raws.inorganics.size(); i++)
-    {
-        df::inorganic_raw *p = raws.inorganics[i];
-        if (p->id == token)
-            return decode(0, i);
-    }
+    int32_t i = RawIndex::findInorganic(token);
+    if (i >= 0)
+        return decode(0, i);
     return decode(-1);
 }
 
@@ -252,23 +249,19 @@ bool MaterialInfo::findPlant(const std::string &token, const std::string &subtok
 {
     if (token.empty())
         return decode(-1);
-    df::world_raws &raws = world->raws;
-    for (size_t i = 0; i < raws.plants.all.size(); i++)
-    {
-        df::plant_raw *p = raws.plants.all[i];
-        if (p->id != token)
-            continue;
+    int32_t i = RawIndex::findPlant(token);
+    if (i < 0)
+        return decode(-1);
+    df::plant_raw *p = world->raws.plants.all[i];
 
-        // As a special exception, return the structural material with empty subtoken
-        if (subtoken.empty())
-            return decode(p->material_defs.type[plant_material_def::basic_mat], p->material_defs.idx[plant_material_def::basic_mat]);
+    // As a special exception, return the structural material with empty subtoken
+    if (subtoken.empty())
+        return decode(p->material_defs.type[plant_material_def::basic_mat], p->material_defs.idx[plant_material_def::basic_mat]);
 
-        for (size_t j = 0; j < p->material.size(); j++)
-            if (p->material[j]->id == subtoken)
-                return decode(PLANT_BASE+j, i);
+    for (size_t j = 0; j < p->material.size(); j++)
+        if (p->material[j]->id == subtoken)
+            return decode(PLANT_BASE+j, i);
 
-        break;
-    }
     return decode(-1);
 }
 
@@ -276,19 +269,15 @@ bool MaterialInfo::findCreature(const std::string &token, const std::string &sub
 {
     if (token.empty() || subtoken.empty())
         return decode(-1);
-    df::world_raws &raws = world->raws;
-    for (size_t i = 0; i < raws.creatures.all.size(); i++)
-    {
-        df::creature_raw *p = raws.creatures.all[i];
-        if (p->creature_id != token)
-            continue;
+    int32_t i = RawIndex::findCreature(token);
+    if (i < 0)
+        return decode(-1);
+    df::creature_raw *p = world->raws.creatures.all[i];
 
-        for (size_t j = 0; j < p->material.size(); j++)
-            if (p->material[j]->id == subtoken)
-                return decode(CREATURE_BASE+j, i);
+    for (size_t j = 0; j < p->material.size(); j++)
+        if (p->material[j]->id == subtoken)
+            return decode(CREATURE_BASE+j, i);
 
-        break;
-    }
     return decode(-1);
 }
 
@@ -0,0 +1,154 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "Internal.h"
+
+#include "Core.h"
+#include "DataDefs.h"
+#include "Error.h"
+#include "PerfCounters.h"
+
+#include "modules/Orders.h"
+
+#include "df/manager_order.h"
+#include "df/world.h"
+
+#include <unordered_map>
+
+using namespace DFHack;
+using namespace df::enums;
+
+using df::global::world;
+
+namespace {
+    // what the index was built from. A new next id or a different number of
+    // orders means the list changed behind our back. Anything subtler, like
+    // an order moved up or down the list, is caught by comparing the whole
+    // pointer sequence, which is done at most once per Core update.
+    struct Fingerprint {
+        std::vector<df::manager_order *> orders;
+        int32_t next_id = -1;
+        uint32_t checked_update = 0;
+
+        bool matches(const std::vector<df::manager_order *> &cur) {
+            if (next_id != world->manager_order_next_id || orders.size() != cur.size())
+                return false;
+            uint32_t update = Core::getInstance().getUpdateCount();
+            if (checked_update == update)
+                return true;
+            if (orders != cur)
+                return false;
+            checked_update = update;
+            return true;
+        }
+
+        void assign(const std::vector<df::manager_order *> &cur) {
+            orders.assign(cur.begin(), cur.end());
+            next_id = world->manager_order_next_id;
+            checked_update = Core::getInstance().getUpdateCount();
+        }
+    };
+}
+
+static bool index_valid = false;
+static Fingerprint index_fingerprint;
+static std::unordered_map<uint64_t, std::vector<df::manager_order *>> order_index;
+static const std::vector<df::manager_order *> no_orders;
+
+static uint64_t bucket_key(df::job_type job_type, int16_t item_subtype) {
+    return (uint64_t(uint32_t(job_type)) << 16) | uint16_t(item_subtype);
+}
+
+static void refresh_index() {
+    static auto &hits = PerfCounters::getCounter("orders/index/hit");
+    static auto &rebuilds = PerfCounters::getCounter("orders/index/rebuild");
+
+    auto &orders = world->manager_orders;
+    if (index_valid && index_fingerprint.matches(orders)) {
+        hits.add();
+        return;
+    }
+
+    rebuilds.add();
+    for (auto &[_, bucket] : order_index)
+        bucket.clear();
+    for (auto order : orders)
+        order_index[bucket_key(order->job_type, order->item_subtype)].push_back(order);
+    index_fingerprint.assign(orders);
+    index_valid = true;
+}
+
+bool Orders::OrderSpec::matches(const df::manager_order *order) const {
+    return order->job_type == job_type &&
+        order->item_type == item_type &&
+        order->item_subtype == item_subtype &&
+        order->mat_type == mat_type &&
+        order->mat_index == mat_index &&
+        order->material_category.whole == material_category &&
+        order->hist_figure_id == hist_figure_id;
+}
+
+const std::vector<df::manager_order *> &Orders::getOrders(df::job_type job_type, int16_t item_subtype) {
+    refresh_index();
+    auto it = order_index.find(bucket_key(job_type, item_subtype));
+    return it == order_index.end() ? no_orders : it->second;
+}
+
+df::manager_order *Orders::findOrder(const OrderSpec &spec) {
+    for (auto order : getOrders(spec.job_type, spec.item_subtype)) {
+        if (spec.matches(order))
+            return order;
+    }
+    return NULL;
+}
+
+int32_t Orders::getAmountLeft(const OrderSpec &spec) {
+    int32_t amount = 0;
+    for (auto order : getOrders(spec.job_type, spec.item_subtype)) {
+        if (spec.matches(order))
+            amount += order->amount_left;
+    }
+    return amount;
+}
+
+void Orders::addOrder(df::manager_order *order) {
+    CHECK_NULL_POINTER(order);
+
+    refresh_index();
+    if (order->id < 0)
+        order->id = world->manager_order_next_id++;
+    else if (order->id >= world->manager_order_next_id)
+        world->manager_order_next_id = order->id + 1;
+
+    world->manager_orders.push_back(order);
+    order_index[bucket_key(order->job_type, order->item_subtype)].push_back(order);
+    index_fingerprint.orders.push_back(order);
+    index_fingerprint.next_id = world->manager_order_next_id;
+}
+
+void Orders::invalidate() {
+    index_valid = false;
+    order_index.clear();
+    index_fingerprint = Fingerprint();
+}
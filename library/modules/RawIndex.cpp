@@ -0,0 +1,136 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "Internal.h"
+
+#include "DataDefs.h"
+#include "Error.h"
+#include "PerfCounters.h"
+
+#include "modules/Items.h"
+#include "modules/RawIndex.h"
+
+#include "df/creature_raw.h"
+#include "df/inorganic_raw.h"
+#include "df/itemdef.h"
+#include "df/plant_raw.h"
+#include "df/world.h"
+
+#include <map>
+#include <unordered_map>
+
+using namespace DFHack;
+using namespace df::enums;
+
+using df::global::world;
+
+namespace {
+    // id -> index for one raw vector, along with what it was built from;
+    // any difference means the raws were reloaded and the table is stale
+    struct Table {
+        bool built = false;
+        size_t size = 0;
+        const void *front = NULL;
+        std::unordered_map<std::string, int32_t> ids;
+
+        template<typename GetId>
+        void refresh(size_t cur_size, const void *cur_front, GetId get_id) {
+            static auto &hits = PerfCounters::getCounter("rawindex/hit");
+            static auto &rebuilds = PerfCounters::getCounter("rawindex/rebuild");
+
+            if (built && size == cur_size && front == cur_front) {
+                hits.add();
+                return;
+            }
+
+            rebuilds.add();
+            ids.clear();
+            ids.reserve(cur_size);
+            for (size_t i = 0; i < cur_size; i++) {
+                // keep the first of any duplicate ids, like the linear scans did
+                ids.emplace(get_id(i), int32_t(i));
+            }
+            built = true;
+            size = cur_size;
+            front = cur_front;
+        }
+
+        template<typename T, typename GetId>
+        void refresh(const std::vector<T *> &vec, GetId get_id) {
+            refresh(vec.size(), vec.empty() ? NULL : vec.front(),
+                [&](size_t i) -> const std::string & { return get_id(vec[i]); });
+        }
+
+        int32_t find(const std::string &id) const {
+            auto it = ids.find(id);
+            return it == ids.end() ? -1 : it->second;
+        }
+    };
+}
+
+static Table inorganics;
+static Table plants;
+static Table creatures;
+static std::map<df::item_type, Table> itemdefs;
+
+int32_t RawIndex::findInorganic(const std::string &id) {
+    CHECK_NULL_POINTER(world);
+    inorganics.refresh(world->raws.inorganics,
+        [](df::inorganic_raw *raw) -> const std::string & { return raw->id; });
+    return inorganics.find(id);
+}
+
+int32_t RawIndex::findPlant(const std::string &id) {
+    CHECK_NULL_POINTER(world);
+    plants.refresh(world->raws.plants.all,
+        [](df::plant_raw *raw) -> const std::string & { return raw->id; });
+    return plants.find(id);
+}
+
+int32_t RawIndex::findCreature(const std::string &id) {
+    CHECK_NULL_POINTER(world);
+    creatures.refresh(world->raws.creatures.all,
+        [](df::creature_raw *raw) -> const std::string & { return raw->creature_id; });
+    return creatures.find(id);
+}
+
+int16_t RawIndex::findItemSubtype(df::item_type type, const std::string &id) {
+    CHECK_NULL_POINTER(world);
+    int count = Items::getSubtypeCount(type);
+    if (count <= 0)
+        return -1;
+
+    auto &table = itemdefs[type];
+    table.refresh(size_t(count), Items::getSubtypeDef(type, 0),
+        [type](size_t i) -> const std::string & { return Items::getSubtypeDef(type, i)->id; });
+    return int16_t(table.find(id));
+}
+
+void RawIndex::invalidate() {
+    inorganics = Table();
+    plants = Table();
+    creatures = Table();
+    itemdefs.clear();
+}
@@ -25,6 +25,7 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
@@ -116,6 +117,13 @@ bool Screen::inGraphicsMode()
     return init && init->display.flag.is_set(init_display_flags::USE_GRAPHICS);
 }
 
+static void writeTile_map(const Pen &pen, df::graphic_viewportst *vp, size_t index) {
+    long texpos = pen.tile;
+    if (!texpos && pen.ch)
+        texpos = init->font.large_font_texpos[(uint8_t)pen.ch];
+    vp->screentexpos_interface[index] = texpos;
+}
+
 static bool doSetTile_map(const Pen &pen, int x, int y) {
     auto &vp = gps->main_viewport;
 
@@ -128,29 +136,14 @@ static bool doSetTile_map(const Pen &pen, int x, int y) {
     if (index > max_index)
         return false;
 
-    long texpos = pen.tile;
-    if (!texpos && pen.ch)
-        texpos = init->font.large_font_texpos[(uint8_t)pen.ch];
-    vp->screentexpos_interface[index] = texpos;
+    writeTile_map(pen, vp, index);
     return true;
 }
 
-static bool doSetTile_default(const Pen &pen, int x, int y, bool map)
+// writes one pen to the interface buffers at an already validated index
+static void writeTile(const Pen &pen, size_t index, bool use_graphics)
 {
-    bool use_graphics = Screen::inGraphicsMode();
-
-    if (map && use_graphics)
-        return doSetTile_map(pen, x, y);
-
-    if (x < 0 || x >= gps->dimx || y < 0 || y >= gps->dimy)
-        return false;
-
-    size_t index = (x * gps->dimy) + y;
     uint8_t *screen = &gps->screen[index * 8];
-
-    if (screen > gps->screen_limit)
-        return false;
-
     long *texpos = &gps->screentexpos[index];
     long *texpos_lower = &gps->screentexpos_lower[index];
     uint32_t *flag = &gps->screentexpos_flag[index];
@@ -222,7 +215,23 @@ static bool doSetTile_default(const Pen &pen, int x, int y, bool map)
     screen[4] = rgb_bg[0];
     screen[5] = rgb_bg[1];
     screen[6] = rgb_bg[2];
+}
 
+static bool doSetTile_default(const Pen &pen, int x, int y, bool map)
+{
+    bool use_graphics = Screen::inGraphicsMode();
+
+    if (map && use_graphics)
+        return doSetTile_map(pen, x, y);
+
+    if (x < 0 || x >= gps->dimx || y < 0 || y >= gps->dimy)
+        return false;
+
+    size_t index = (x * gps->dimy) + y;
+    if (&gps->screen[index * 8] > gps->screen_limit)
+        return false;
+
+    writeTile(pen, index, use_graphics);
     return true;
 }
 
@@ -232,6 +241,74 @@ static bool doSetTile(const Pen &pen, int x, int y, bool map)
     return GUI_HOOK_TOP(Screen::Hooks::set_tile)(pen, x, y, map);
 }
 
+/*
+ * Paints len tiles of row y starting at column x. The pen pointer advances by
+ * pen_step after every tile, so a step of 0 repeats a single pen. The graphics
+ * mode, clipping and buffer limits are resolved once for the whole run rather
+ * than once per tile. Invalid pens are skipped, like in paintTile.
+ */
+static bool doSetSpan_default(const Pen *pens, int pen_step, int x, int y, int len, bool map)
+{
+    // anybody overriding set_tile still gets to see every tile
+    if (GUI_HOOK_TOP(Screen::Hooks::set_tile) != doSetTile_default)
+    {
+        bool ok = false;
+        for (int i = 0; i < len; i++, pens += pen_step)
+        {
+            if (pens->valid())
+                ok = doSetTile(*pens, x + i, y, map) || ok;
+        }
+        return ok;
+    }
+
+    bool use_graphics = Screen::inGraphicsMode();
+    auto vp = gps->main_viewport;
+    bool to_map = map && use_graphics;
+
+    int dimx, dimy;
+    size_t max_index;
+    if (to_map)
+    {
+        dimx = vp->dim_x;
+        dimy = vp->dim_y;
+        max_index = size_t(dimx * dimy) - 1;
+    }
+    else
+    {
+        dimx = gps->dimx;
+        dimy = gps->dimy;
+        max_index = size_t(gps->screen_limit - gps->screen) / 8;
+    }
+
+    if (y < 0 || y >= dimy || len <= 0)
+        return false;
+
+    int start = std::max(x, 0);
+    int end = std::min(x + len, dimx);
+    if (start >= end)
+        return false;
+
+    pens += (start - x) * pen_step;
+    size_t index = size_t(start) * dimy + y;
+    for (int cx = start; cx < end && index <= max_index; cx++, index += dimy, pens += pen_step)
+    {
+        if (!pens->valid())
+            continue;
+        if (to_map)
+            writeTile_map(*pens, vp, index);
+        else
+            writeTile(*pens, index, use_graphics);
+    }
+
+    return true;
+}
+
+GUI_HOOK_DEFINE(Screen::Hooks::set_tile_span, doSetSpan_default);
+static bool doSetSpan(const Pen *pens, int pen_step, int x, int y, int len, bool map)
+{
+    return GUI_HOOK_TOP(Screen::Hooks::set_tile_span)(pens, pen_step, x, y, len, map);
+}
+
 bool Screen::paintTile(const Pen &pen, int x, int y, bool map)
 {
     if (!gps || !pen.valid()) return false;
@@ -240,6 +317,26 @@ bool Screen::paintTile(const Pen &pen, int x, int y, bool map)
     return true;
 }
 
+bool Screen::paintSpan(const Pen *pens, int len, int x, int y, bool map)
+{
+    if (!gps || !pens) return false;
+
+    return doSetSpan(pens, 1, x, y, len, map);
+}
+
+bool Screen::paintRect(const PenArray &pens, int x, int y, bool map)
+{
+    if (!gps) return false;
+
+    bool ok = false;
+    int dimx = pens.get_dimx();
+    int dimy = pens.get_dimy();
+    for (int row = 0; row < dimy; row++)
+        ok = doSetSpan(pens.get_row(row), 1, x, y + row, dimx, map) || ok;
+
+    return ok;
+}
+
 static Pen doGetTile_map(int x, int y) {
     auto &vp = gps->main_viewport;
 
@@ -390,11 +487,8 @@ bool Screen::fillRect(const Pen &pen, int x1, int y1, int x2, int y2, bool map)
     if (y2 >= dim.y) y2 = dim.y-1;
     if (x1 > x2 || y1 > y2) return false;
 
-    for (int x = x1; x <= x2; x++)
-    {
-        for (int y = y1; y <= y2; y++)
-            doSetTile(pen, x, y, map);
-    }
+    for (int y = y1; y <= y2; y++)
+        doSetSpan(&pen, 0, x1, y, x2 - x1 + 1, map);
 
     return true;
 }
@@ -703,19 +797,15 @@ void PenArray::set_tile(unsigned int x, unsigned int y, Screen::Pen pen)
 void PenArray::draw(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
                     unsigned int bufx, unsigned int bufy)
 {
-    if (!gps)
+    if (!gps || bufx >= dimx)
         return;
-    for (unsigned int gridx = x; gridx < x + width; gridx++)
+    unsigned int len = std::min(width, dimx - bufx);
+    for (unsigned int gridy = y; gridy < y + height; gridy++)
     {
-        for (unsigned int gridy = y; gridy < y + height; gridy++)
-        {
-            if (gridx >= unsigned(gps->dimx) ||
-                gridy >= unsigned(gps->dimy) ||
-                gridx - x + bufx >= dimx ||
-                gridy - y + bufy >= dimy)
-                continue;
-            Screen::paintTile(buffer[((gridy - y + bufy) * dimx) + (gridx - x + bufx)], gridx, gridy);
-        }
+        if (gridy >= unsigned(gps->dimy) ||
+            gridy - y + bufy >= dimy)
+            continue;
+        Screen::paintSpan(&buffer[((gridy - y + bufy) * dimx) + bufx], len, x, gridy);
     }
 }
 
@@ -0,0 +1,189 @@
+#include "modules/Screen.h"
+
+#include "DataDefs.h"
+#include "df/graphic.h"
+#include "df/init.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+using namespace DFHack;
+using Screen::Pen;
+using Screen::PenArray;
+
+namespace {
+
+template<typename T>
+using element_t = std::remove_pointer_t<T>;
+
+// A heap-backed stand-in for DF's interface buffers, sized like a large window
+class FakeScreen : public ::testing::Test {
+protected:
+    static const int DIMX = 240;
+    static const int DIMY = 80;
+    static const size_t CELLS = size_t(DIMX) * DIMY;
+
+    df::graphic graphic;
+    df::init init_data;
+
+    std::vector<uint8_t> screen, screen_top;
+    std::vector<element_t<decltype(df::graphic::screentexpos)>> texpos, texpos_top;
+    std::vector<element_t<decltype(df::graphic::screentexpos_lower)>> texpos_lower, texpos_top_lower;
+    std::vector<element_t<decltype(df::graphic::screentexpos_anchored)>> anchored, anchored_top;
+    std::vector<element_t<decltype(df::graphic::screentexpos_flag)>> flag, flag_top;
+
+    void SetUp() override {
+        screen.assign(CELLS * 8, 0);
+        screen_top.assign(CELLS * 8, 0);
+        texpos.assign(CELLS, 0);
+        texpos_top.assign(CELLS, 0);
+        texpos_lower.assign(CELLS, 0);
+        texpos_top_lower.assign(CELLS, 0);
+        anchored.assign(CELLS, 0);
+        anchored_top.assign(CELLS, 0);
+        flag.assign(CELLS, 0);
+        flag_top.assign(CELLS, 0);
+
+        graphic.dimx = DIMX;
+        graphic.dimy = DIMY;
+        graphic.screen = screen.data();
+        graphic.screen_limit = screen.data() + (CELLS - 1) * 8;
+        graphic.screen_top = screen_top.data();
+        graphic.screentexpos = texpos.data();
+        graphic.screentexpos_top = texpos_top.data();
+        graphic.screentexpos_lower = texpos_lower.data();
+        graphic.screentexpos_top_lower = texpos_top_lower.data();
+        graphic.screentexpos_anchored = anchored.data();
+        graphic.screentexpos_top_anchored = anchored_top.data();
+        graphic.screentexpos_flag = flag.data();
+        graphic.screentexpos_top_flag = flag_top.data();
+        graphic.top_in_use = false;
+        for (int c = 0; c < 16; ++c) {
+            graphic.uccolor[c][0] = c * 16;
+            graphic.uccolor[c][1] = 255 - c * 16;
+            graphic.uccolor[c][2] = c;
+        }
+
+        df::global::gps = &graphic;
+        df::global::init = &init_data;
+    }
+
+    void TearDown() override {
+        df::global::gps = nullptr;
+        df::global::init = nullptr;
+    }
+
+    void fillPens(PenArray &pens) {
+        for (int x = 0; x < DIMX; ++x) {
+            for (int y = 0; y < DIMY; ++y) {
+                Pen pen(char('A' + (x + y) % 26), (x * 3 + y) % 16, (x + y * 5) % 8, (x + y) % 4 == 0);
+                pens.set_tile(x, y, pen);
+            }
+        }
+    }
+
+    void paintByTile(PenArray &pens, int ox, int oy) {
+        for (int y = 0; y < DIMY; ++y)
+            for (int x = 0; x < DIMX; ++x)
+                Screen::paintTile(pens.get_tile(x, y), ox + x, oy + y);
+    }
+
+    void clearBuffers() {
+        SetUp();
+    }
+
+    struct Snapshot {
+        std::vector<uint8_t> screen;
+        std::vector<element_t<decltype(df::graphic::screentexpos)>> texpos;
+        std::vector<element_t<decltype(df::graphic::screentexpos_lower)>> texpos_lower;
+        std::vector<element_t<decltype(df::graphic::screentexpos_flag)>> flag;
+
+        bool operator==(const Snapshot &other) const {
+            return screen == other.screen && texpos == other.texpos &&
+                texpos_lower == other.texpos_lower && flag == other.flag;
+        }
+    };
+
+    Snapshot snapshot() const {
+        return Snapshot{screen, texpos, texpos_lower, flag};
+    }
+};
+
+template<typename F>
+double microsPerRun(int runs, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+        fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / runs;
+}
+
+}
+
+TEST_F(FakeScreen, paintRectMatchesPaintTile) {
+    PenArray pens(DIMX, DIMY);
+    fillPens(pens);
+
+    // offset so that both paths have to clip at the window edges
+    paintByTile(pens, -3, 5);
+    Snapshot by_tile = snapshot();
+
+    clearBuffers();
+    EXPECT_TRUE(Screen::paintRect(pens, -3, 5));
+    EXPECT_TRUE(by_tile == snapshot());
+}
+
+TEST_F(FakeScreen, fillRectMatchesPaintTile) {
+    Pen pen('#', 4, 1, true);
+
+    for (int x = 10; x <= 100; ++x)
+        for (int y = 2; y <= 70; ++y)
+            Screen::paintTile(pen, x, y);
+    Snapshot by_tile = snapshot();
+
+    clearBuffers();
+    EXPECT_TRUE(Screen::fillRect(pen, 10, 2, 100, 70));
+    EXPECT_TRUE(by_tile == snapshot());
+}
+
+TEST_F(FakeScreen, paintSpanClipsAndSkipsInvalidPens) {
+    Pen pens[4] = {Pen('a', 1), Pen('b', 2), Pen(0, 0, 0, -1), Pen('d', 4)};
+
+    EXPECT_FALSE(Screen::paintSpan(pens, 4, 0, DIMY));
+    EXPECT_FALSE(Screen::paintSpan(pens, 4, DIMX, 0));
+    EXPECT_TRUE(Screen::paintSpan(pens, 4, DIMX - 3, 0));
+
+    EXPECT_EQ(screen[(DIMX - 3) * DIMY * 8], 'a');
+    EXPECT_EQ(screen[(DIMX - 2) * DIMY * 8], 'b');
+    EXPECT_EQ(screen[(DIMX - 1) * DIMY * 8], 0);
+}
+
+// Not a correctness test: reports how long a full-window repaint takes through
+// each path. Disabled by default; run it with --gtest_also_run_disabled_tests.
+TEST_F(FakeScreen, DISABLED_benchmarkFullWindowFill) {
+    const int RUNS = 50;
+    PenArray pens(DIMX, DIMY);
+    fillPens(pens);
+    Pen pen(' ', 0, 0, false);
+
+    double tile_us = microsPerRun(RUNS, [&] { paintByTile(pens, 0, 0); });
+    double rect_us = microsPerRun(RUNS, [&] { Screen::paintRect(pens, 0, 0); });
+    double tile_fill_us = microsPerRun(RUNS, [&] {
+        for (int x = 0; x < DIMX; ++x)
+            for (int y = 0; y < DIMY; ++y)
+                Screen::paintTile(pen, x, y);
+    });
+    double fill_us = microsPerRun(RUNS, [&] { Screen::fillRect(pen, 0, 0, DIMX - 1, DIMY - 1); });
+
+    printf("%dx%d window, us per full repaint:\n", DIMX, DIMY);
+    printf("  pen array: paintTile %9.1f  paintRect %9.1f\n", tile_us, rect_us);
+    printf("  one pen:   paintTile %9.1f  fillRect  %9.1f\n", tile_fill_us, fill_us);
+
+    RecordProperty("paintTile_us", int(tile_us));
+    RecordProperty("paintRect_us", int(rect_us));
+    RecordProperty("fillRect_us", int(fill_us));
+}
@@ -1,15 +1,19 @@
 #include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <cstring>
 #include <numeric>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Internal.h"
 
 #include "modules/DFSDL.h"
+#include "modules/Filesystem.h"
 #include "modules/Textures.h"
 
 #include "Debug.h"
+#include "PerfCounters.h"
 #include "PluginManager.h"
 #include "VTableInterpose.h"
 
@@ -54,8 +58,25 @@ static ReservedRange reserved_range{};
 static std::unordered_map<TexposHandle, long> g_handle_to_texpos;
 static std::unordered_map<TexposHandle, long> g_handle_to_reserved_texpos;
 static std::unordered_map<TexposHandle, SDL_Surface*> g_handle_to_surface;
-static std::unordered_map<std::string, std::vector<TexposHandle>> g_tileset_to_handles;
 static std::vector<TexposHandle> g_delayed_regs;
+static std::unordered_set<TexposHandle> g_delayed_regs_set;
+
+struct LoadedTileset {
+    int64_t mtime;
+    int tile_px_w;
+    int tile_px_h;
+    std::vector<TexposHandle> handles;
+};
+static std::unordered_map<std::string, LoadedTileset> g_tileset_to_handles;
+
+// Decoded, canonicalized images keyed by file path. A tileset whose handles
+// have been deleted can be sliced again from here without touching the disk,
+// as long as the file's mtime hasn't changed.
+struct TilesetAtlas {
+    int64_t mtime;
+    SDL_Surface* surface;
+};
+static std::unordered_map<std::string, TilesetAtlas> g_atlas_cache;
 static std::mutex g_adding_mutex;
 static std::atomic<bool> loading_state = false;
 static SDL_Surface* dummy_surface = NULL;
@@ -99,6 +120,21 @@ static long add_texture(SDL_Surface* surface) {
     return texpos;
 }
 
+// register a batch of surfaces in texture raws, get the texpos of the first one
+static long add_textures(const std::vector<SDL_Surface*>& surfaces) {
+    std::lock_guard<std::mutex> lg_add_texture(g_adding_mutex);
+    auto texpos = enabler->textures.raws.size();
+    enabler->textures.raws.reserve(texpos + surfaces.size());
+    for (auto surface : surfaces)
+        enabler->textures.raws.push_back(surface);
+    return texpos;
+}
+
+static void delay_registration(TexposHandle handle) {
+    if (g_delayed_regs_set.insert(handle).second)
+        g_delayed_regs.push_back(handle);
+}
+
 // register surface in texture raws to specific texpos
 static void insert_texture(SDL_Surface* surface, long texpos) {
     std::lock_guard<std::mutex> lg_add_texture(g_adding_mutex);
@@ -126,8 +162,30 @@ SDL_Surface* create_texture(std::vector<uint32_t>& pixels, int texture_px_w, int
     return surface;
 }
 
+// copy one tile out of an atlas; RGBA32 atlases (everything we load or
+// create ourselves) are copied row by row instead of going through a blit
+static SDL_Surface* copy_tile(SDL_Surface* surface, int x, int y, int tile_px_w, int tile_px_h) {
+    if (surface->format->format != SDL_PixelFormatEnum::SDL_PIXELFORMAT_RGBA32) {
+        SDL_Surface* tile = DFSDL_CreateRGBSurface(
+            0, tile_px_w, tile_px_h, 32, surface->format->Rmask, surface->format->Gmask,
+            surface->format->Bmask, surface->format->Amask);
+        SDL_Rect vp{tile_px_w * x, tile_px_h * y, tile_px_w, tile_px_h};
+        DFSDL_UpperBlit(surface, &vp, tile, NULL);
+        return tile;
+    }
+
+    SDL_Surface* tile = DFSDL_CreateRGBSurfaceWithFormat(0, tile_px_w, tile_px_h, 32,
+                                                         SDL_PixelFormatEnum::SDL_PIXELFORMAT_RGBA32);
+    auto src = (const uint8_t*)surface->pixels + tile_px_h * y * surface->pitch + tile_px_w * x * 4;
+    auto dst = (uint8_t*)tile->pixels;
+    for (int row = 0; row < tile_px_h; row++)
+        memcpy(dst + row * tile->pitch, src + row * surface->pitch, tile_px_w * 4);
+    return tile;
+}
+
 // convert single surface into tiles according w/h
 // register tiles in texture raws and return handles
+// the source surface is left to the caller
 std::vector<TexposHandle> slice_tileset(SDL_Surface* surface, int tile_px_w, int tile_px_h,
                                         bool reserved) {
     std::vector<TexposHandle> handles{};
@@ -143,22 +201,60 @@ std::vector<TexposHandle> slice_tileset(SDL_Surface* surface, int tile_px_w, int
         reserved = false;
     }
 
+    std::vector<SDL_Surface*> tiles;
+    tiles.reserve(dimx * dimy);
     for (int y = 0; y < dimy; y++) {
-        for (int x = 0; x < dimx; x++) {
-            SDL_Surface* tile = DFSDL_CreateRGBSurface(
-                0, tile_px_w, tile_px_h, 32, surface->format->Rmask, surface->format->Gmask,
-                surface->format->Bmask, surface->format->Amask);
-            SDL_Rect vp{tile_px_w * x, tile_px_h * y, tile_px_w, tile_px_h};
-            DFSDL_UpperBlit(surface, &vp, tile, NULL);
-            auto handle = Textures::loadTexture(tile, reserved);
-            handles.push_back(handle);
-        }
+        for (int x = 0; x < dimx; x++)
+            tiles.push_back(copy_tile(surface, x, y, tile_px_w, tile_px_h));
     }
 
-    DFSDL_FreeSurface(surface);
+    if (reserved || loading_state) {
+        for (auto tile : tiles)
+            handles.push_back(Textures::loadTexture(tile, reserved));
+        return handles;
+    }
+
+    // dynamic range outside of loading: register the whole tileset at once
+    handles.reserve(tiles.size());
+    for (auto tile : tiles) {
+        auto handle = reinterpret_cast<uintptr_t>(tile);
+        g_handle_to_surface.emplace(handle, tile);
+        tile->refcount++; // prevent destruct on next FreeSurface by game
+        handles.push_back(handle);
+    }
+    long texpos = add_textures(tiles);
+    for (auto handle : handles)
+        g_handle_to_texpos.emplace(handle, texpos++);
+
     return handles;
 }
 
+// returns the decoded image for the file, reading it only if it is not cached
+// or has changed on disk since it was cached
+static SDL_Surface* get_atlas(const std::string& file, int64_t mtime) {
+    static auto& atlas_hits = PerfCounters::getCounter("textures/loadTileset/atlas-hit");
+    static auto& decodes = PerfCounters::getCounter("textures/loadTileset/decode");
+
+    auto it = g_atlas_cache.find(file);
+    if (it != g_atlas_cache.end()) {
+        if (it->second.mtime == mtime) {
+            atlas_hits.add();
+            return it->second.surface;
+        }
+        DFSDL_FreeSurface(it->second.surface);
+        g_atlas_cache.erase(it);
+    }
+
+    SDL_Surface* surface = DFIMG_Load(file.c_str());
+    if (!surface)
+        return NULL;
+
+    decodes.add();
+    surface = canonicalize_format(surface);
+    g_atlas_cache.emplace(file, TilesetAtlas{mtime, surface});
+    return surface;
+}
+
 TexposHandle Textures::loadTexture(SDL_Surface* surface, bool reserved) {
     if (!surface || !enabler)
         return 0; // should be some error, i guess
@@ -186,7 +282,7 @@ TexposHandle Textures::loadTexture(SDL_Surface* surface, bool reserved) {
 
     // if we here in loading state = true, then it should be dynamic range -> delay reg
     if (loading_state) {
-        g_delayed_regs.push_back(handle);
+        delay_registration(handle);
     } else {
         auto texpos = add_texture(surface);
         g_handle_to_texpos.emplace(handle, texpos);
@@ -197,22 +293,38 @@ TexposHandle Textures::loadTexture(SDL_Surface* surface, bool reserved) {
 
 std::vector<TexposHandle> Textures::loadTileset(const std::string& file, int tile_px_w,
                                                 int tile_px_h, bool reserved) {
-    if (g_tileset_to_handles.contains(file))
-        return g_tileset_to_handles[file];
+    static auto& load_latency = PerfCounters::get("textures/loadTileset");
+    static auto& handle_hits = PerfCounters::getCounter("textures/loadTileset/handle-hit");
+    PerfTimer timer(load_latency);
+
     if (!enabler)
         return std::vector<TexposHandle>{};
 
-    SDL_Surface* surface = DFIMG_Load(file.c_str());
+    int64_t mtime = Filesystem::mtime(file);
+
+    // hand out the existing handles unless they have been deleted, the file
+    // has changed, or the tileset is being sliced differently
+    if (auto it = g_tileset_to_handles.find(file); it != g_tileset_to_handles.end()) {
+        auto& loaded = it->second;
+        if (loaded.mtime == mtime && loaded.tile_px_w == tile_px_w &&
+            loaded.tile_px_h == tile_px_h &&
+            std::all_of(loaded.handles.begin(), loaded.handles.end(),
+                        [](TexposHandle handle) { return g_handle_to_surface.contains(handle); })) {
+            handle_hits.add();
+            return loaded.handles;
+        }
+    }
+
+    SDL_Surface* surface = get_atlas(file, mtime);
     if (!surface) {
         ERR(textures).printerr("unable to load textures from '%s'\n", file.c_str());
         return std::vector<TexposHandle>{};
     }
 
-    surface = canonicalize_format(surface);
     auto handles = slice_tileset(surface, tile_px_w, tile_px_h, reserved);
 
     DEBUG(textures).print("loaded %zd textures from '%s'\n", handles.size(), file.c_str());
-    g_tileset_to_handles[file] = handles;
+    g_tileset_to_handles[file] = LoadedTileset{mtime, tile_px_w, tile_px_h, handles};
 
     return handles;
 }
@@ -225,12 +337,12 @@ long Textures::getTexposByHandle(TexposHandle handle) {
         return g_handle_to_reserved_texpos[handle];
     if (g_handle_to_texpos.contains(handle))
         return g_handle_to_texpos[handle];
-    if (std::find(g_delayed_regs.begin(), g_delayed_regs.end(), handle) != g_delayed_regs.end())
+    if (g_delayed_regs_set.contains(handle))
         return 0;
     if (g_handle_to_surface.contains(handle)) {
         g_handle_to_surface[handle]->refcount++; // prevent destruct on next FreeSurface by game
         if (loading_state) { // reinit dor dynamic range during loading -> delayed
-            g_delayed_regs.push_back(handle);
+            delay_registration(handle);
             return 0;
         }
         auto texpos = add_texture(g_handle_to_surface[handle]);
@@ -259,6 +371,7 @@ std::vector<TexposHandle> Textures::createTileset(std::vector<uint32_t>& pixels,
 
     auto texture = create_texture(pixels, texture_px_w, texture_px_h);
     auto handles = slice_tileset(texture, tile_px_w, tile_px_h, reserved);
+    DFSDL_FreeSurface(texture);
     return handles;
 }
 
@@ -273,9 +386,9 @@ void Textures::deleteHandle(TexposHandle handle) {
         g_handle_to_reserved_texpos.erase(handle);
     if (g_handle_to_texpos.contains(handle))
         g_handle_to_texpos.erase(handle);
-    if (auto it = std::find(g_delayed_regs.begin(), g_delayed_regs.end(), handle);
-        it != g_delayed_regs.end())
-        g_delayed_regs.erase(it);
+    if (g_delayed_regs_set.erase(handle)) {
+        g_delayed_regs.erase(std::find(g_delayed_regs.begin(), g_delayed_regs.end(), handle));
+    }
     if (g_handle_to_surface.contains(handle)) {
         auto surface = g_handle_to_surface[handle];
         while (surface->refcount)
@@ -299,6 +412,14 @@ static void reset_tilesets() {
     g_tileset_to_handles.clear();
 }
 
+static void reset_atlases() {
+    DEBUG(textures).print("deleting cached tileset images\n");
+    for (auto& entry : g_atlas_cache) {
+        DFSDL_FreeSurface(entry.second.surface);
+    }
+    g_atlas_cache.clear();
+}
+
 static void reset_surface() {
     DEBUG(textures).print("deleting cached surfaces\n");
     for (auto& entry : g_handle_to_surface) {
@@ -309,11 +430,15 @@ static void reset_surface() {
 
 static void register_delayed_handles() {
     DEBUG(textures).print("register delayed handles, size %zd\n", g_delayed_regs.size());
-    for (auto& handle : g_delayed_regs) {
-        auto texpos = add_texture(g_handle_to_surface[handle]);
-        g_handle_to_texpos.emplace(handle, texpos);
-    }
+    std::vector<SDL_Surface*> surfaces;
+    surfaces.reserve(g_delayed_regs.size());
+    for (auto& handle : g_delayed_regs)
+        surfaces.push_back(g_handle_to_surface[handle]);
+    long texpos = add_textures(surfaces);
+    for (auto& handle : g_delayed_regs)
+        g_handle_to_texpos.emplace(handle, texpos++);
     g_delayed_regs.clear();
+    g_delayed_regs_set.clear();
 }
 
 // reset point on New Game
@@ -457,6 +582,7 @@ void Textures::cleanup() {
     reset_texpos();
     reset_reserved_texpos();
     reset_tilesets();
+    reset_atlases();
     reset_surface();
     uninstall_reset_point();
 }
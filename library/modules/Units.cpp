@@ -908,6 +908,154 @@ bool Units::getCitizens(std::vector<df::unit *> &citizens, bool ignore_sanity) {
     return true;
 }
 
+static bool isContainedInItem(df::unit *unit)
+{
+    for (auto ref : unit->general_refs)
+    {
+        if (ref->getType() == general_ref_type::CONTAINED_IN_ITEM)
+            return true;
+    }
+    return false;
+}
+
+static const std::map<std::string, std::pair<Units::UnitQuery::Predicate, Units::UnitQuery::Cost>> &get_named_unit_filters()
+{
+    using Units::UnitQuery;
+    static const std::map<std::string, std::pair<UnitQuery::Predicate, UnitQuery::Cost>> filters = {
+        { "caged", { isContainedInItem, UnitQuery::MODERATE } },
+        { "egglayer", { Units::isEggLayer, UnitQuery::MODERATE } },
+        { "female", { Units::isFemale, UnitQuery::CHEAP } },
+        { "grazer", { Units::isGrazer, UnitQuery::MODERATE } },
+        { "hunting", { Units::isHunter, UnitQuery::CHEAP } },
+        { "male", { Units::isMale, UnitQuery::CHEAP } },
+        { "merchant", { [](df::unit *unit) { return Units::isMerchant(unit) || Units::isForest(unit); }, UnitQuery::CHEAP } },
+        { "milkable", { Units::isMilkable, UnitQuery::MODERATE } },
+        { "naked", { Units::isNaked, UnitQuery::EXPENSIVE } },
+        { "named", { [](df::unit *unit) { return unit->name.has_name; }, UnitQuery::CHEAP } },
+        { "own", { Units::isOwnCiv, UnitQuery::CHEAP } },
+        { "tamable", { Units::isTamable, UnitQuery::MODERATE } },
+        { "tame", { Units::isTame, UnitQuery::CHEAP } },
+        { "trainablehunt", { [](df::unit *unit) {
+            return !Units::isWar(unit) && !Units::isHunter(unit) && Units::isTrainableHunting(unit);
+        }, UnitQuery::MODERATE } },
+        { "trainablewar", { [](df::unit *unit) {
+            return !Units::isWar(unit) && !Units::isHunter(unit) && Units::isTrainableWar(unit);
+        }, UnitQuery::MODERATE } },
+        { "trained", { Units::isTrained, UnitQuery::CHEAP } },
+        { "war", { Units::isWar, UnitQuery::CHEAP } },
+    };
+    return filters;
+}
+
+Units::UnitQuery &Units::UnitQuery::add(Predicate pred, Cost cost, bool negate)
+{
+    auto pos = std::upper_bound(steps.begin(), steps.end(), cost,
+        [](Cost cost, const Step &step) { return cost < step.cost; });
+    steps.insert(pos, Step{std::move(pred), cost, negate});
+    return *this;
+}
+
+bool Units::UnitQuery::addNamed(const std::string &name, bool negate)
+{
+    auto &filters = get_named_unit_filters();
+    auto it = filters.find(name);
+    if (it == filters.end())
+        return false;
+    add(it->second.first, it->second.second, negate);
+    return true;
+}
+
+Units::UnitQuery &Units::UnitQuery::race(const std::string &creature_id, bool negate)
+{
+    auto &creatures = world->raws.creatures.all;
+    for (size_t i = 0; i < creatures.size(); i++)
+    {
+        if (creatures[i] && creatures[i]->creature_id == creature_id)
+            return race(int32_t(i), negate);
+    }
+    return add([](df::unit *) { return false; }, CHEAP, negate);
+}
+
+Units::UnitQuery &Units::UnitQuery::race(int32_t race_id, bool negate)
+{
+    return add([race_id](df::unit *unit) { return unit->race == race_id; }, CHEAP, negate);
+}
+
+// Age is compared against the birth date instead of calling getAge for every
+// unit; the bound is computed once from the current date.
+Units::UnitQuery &Units::UnitQuery::addBirthBound(double years, bool upper, bool negate)
+{
+    using df::global::cur_year;
+    using df::global::cur_year_tick;
+
+    if (!cur_year || !cur_year_tick)
+        return add([](df::unit *) { return false; }, CHEAP, negate);
+
+    static const double year_ticks = 403200.0;
+    double threshold = *cur_year + *cur_year_tick / year_ticks - years;
+    if (upper) // age <= years  <=>  birth >= now - years
+        return add([threshold](df::unit *unit) {
+            return unit->birth_year + unit->birth_time / year_ticks >= threshold;
+        }, CHEAP, negate);
+    // age >= years  <=>  birth <= now - years
+    return add([threshold](df::unit *unit) {
+        return unit->birth_year + unit->birth_time / year_ticks <= threshold;
+    }, CHEAP, negate);
+}
+
+Units::UnitQuery &Units::UnitQuery::minAge(double years, bool negate)
+{
+    return addBirthBound(years, false, negate);
+}
+
+Units::UnitQuery &Units::UnitQuery::maxAge(double years, bool negate)
+{
+    return addBirthBound(years, true, negate);
+}
+
+Units::UnitQuery &Units::UnitQuery::age(int years, bool negate)
+{
+    if (!negate)
+        return minAge(years).addBirthBound(years + 1, false, true);
+
+    // not (years <= age < years + 1)
+    UnitQuery range;
+    range.minAge(years).addBirthBound(years + 1, false, true);
+    return add([range](df::unit *unit) { return range.matches(unit); }, CHEAP, true);
+}
+
+bool Units::UnitQuery::matches(df::unit *unit) const
+{
+    for (auto &step : steps)
+    {
+        if (step.pred(unit) == step.negate)
+            return false;
+    }
+    return true;
+}
+
+void Units::UnitQuery::select(std::vector<df::unit *> &out, const std::vector<df::unit *> &units) const
+{
+    for (auto unit : units)
+    {
+        if (unit && matches(unit))
+            out.push_back(unit);
+    }
+}
+
+bool Units::UnitQuery::hasFilter(const std::string &name)
+{
+    return get_named_unit_filters().count(name) != 0;
+}
+
+std::vector<std::string> Units::UnitQuery::getFilterNames()
+{
+    std::vector<std::string> names;
+    for (auto &entry : get_named_unit_filters())
+        names.push_back(entry.first);
+    return names;
+}
+
 int32_t Units::findIndexById(int32_t creature_id)
 {
     return df::unit::binsearch_index(world->units.all, creature_id);
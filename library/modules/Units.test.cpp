@@ -0,0 +1,115 @@
+#include "modules/Units.h"
+
+#include "DataDefs.h"
+#include "df/unit.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace DFHack;
+using Units::UnitQuery;
+
+namespace {
+
+class UnitQueryTest : public ::testing::Test {
+protected:
+    int32_t year = 110;
+    int32_t year_tick = 0;
+
+    void SetUp() override {
+        df::global::cur_year = &year;
+        df::global::cur_year_tick = &year_tick;
+    }
+
+    void TearDown() override {
+        df::global::cur_year = nullptr;
+        df::global::cur_year_tick = nullptr;
+    }
+};
+
+}
+
+TEST_F(UnitQueryTest, evaluatesCheapestFirst) {
+    std::string trace;
+    auto step = [&](char name, bool result) {
+        return [&trace, name, result](df::unit *) { trace += name; return result; };
+    };
+
+    UnitQuery query;
+    query.add(step('e', true), UnitQuery::EXPENSIVE);
+    query.add(step('m', true), UnitQuery::MODERATE);
+    query.add(step('c', true), UnitQuery::CHEAP);
+    query.add(step('C', true), UnitQuery::CHEAP);
+
+    df::unit unit;
+    EXPECT_TRUE(query.matches(&unit));
+    EXPECT_EQ("cCme", trace);
+
+    trace.clear();
+    query.add(step('x', false), UnitQuery::CHEAP);
+    EXPECT_FALSE(query.matches(&unit));
+    EXPECT_EQ("cCx", trace);
+}
+
+TEST_F(UnitQueryTest, negate) {
+    UnitQuery query;
+    query.add([](df::unit *unit) { return unit->id == 1; }, UnitQuery::CHEAP, true);
+
+    df::unit one, two;
+    one.id = 1;
+    two.id = 2;
+    std::vector<df::unit *> units = {&one, &two, nullptr};
+    std::vector<df::unit *> selected;
+    query.select(selected, units);
+    ASSERT_EQ(1u, selected.size());
+    EXPECT_EQ(&two, selected[0]);
+}
+
+TEST_F(UnitQueryTest, raceById) {
+    df::unit dog, cat;
+    dog.race = 3;
+    cat.race = 4;
+
+    UnitQuery query;
+    query.race(3);
+    EXPECT_TRUE(query.matches(&dog));
+    EXPECT_FALSE(query.matches(&cat));
+
+    UnitQuery not_dogs;
+    not_dogs.race(3, true);
+    EXPECT_FALSE(not_dogs.matches(&dog));
+    EXPECT_TRUE(not_dogs.matches(&cat));
+}
+
+TEST_F(UnitQueryTest, ageBounds) {
+    // half a year past the second birthday
+    df::unit unit;
+    unit.birth_year = year - 3;
+    unit.birth_time = 201600;
+
+    EXPECT_TRUE(UnitQuery().age(2).matches(&unit));
+    EXPECT_FALSE(UnitQuery().age(3).matches(&unit));
+    EXPECT_FALSE(UnitQuery().age(2, true).matches(&unit));
+    EXPECT_TRUE(UnitQuery().minAge(2.5).matches(&unit));
+    EXPECT_FALSE(UnitQuery().minAge(2.6).matches(&unit));
+    EXPECT_TRUE(UnitQuery().maxAge(2.5).matches(&unit));
+    EXPECT_FALSE(UnitQuery().maxAge(2.4).matches(&unit));
+}
+
+TEST_F(UnitQueryTest, namedFilters) {
+    EXPECT_TRUE(UnitQuery::hasFilter("tame"));
+    EXPECT_FALSE(UnitQuery::hasFilter("unassigned"));
+
+    UnitQuery query;
+    EXPECT_FALSE(query.addNamed("no such filter"));
+    EXPECT_TRUE(query.empty());
+
+    df::unit named, unnamed;
+    named.name.has_name = true;
+    unnamed.name.has_name = false;
+    EXPECT_TRUE(query.addNamed("named", true));
+    EXPECT_FALSE(query.matches(&named));
+    EXPECT_TRUE(query.matches(&unnamed));
+}
@@ -255,6 +255,20 @@ enum unit_ptr_index {
  ma_index = 3
 };
 
+// Fort livestock of one race, split by sex and age (see unit_ptr_index).
+struct RaceCensus {
+    // tallies for the watch list UI
+    unsigned total[4] = {};
+    unsigned prot[4] = {};        // not tame, or protected
+    unsigned butcherable[4] = {};
+    unsigned butcherflag[4] = {}; // already marked for slaughter
+
+    // tame units not yet marked for slaughter, as autobutcher_cycle sees them
+    unsigned stock_prot[4] = {};
+    vector<df::unit*> stock[4];
+    vector<df::unit*> stock_priority[4];
+};
+
 struct WatchedRace {
 public:
     PersistentDataItem rconfig;
@@ -338,49 +352,14 @@ public:
         sort(prot_ptr[ma_index].begin(), prot_ptr[ma_index].end(), compareUnitAgesYounger);
     }
 
-    void PushUnit(df::unit *unit) {
-        if(Units::isFemale(unit)) {
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                unit_ptr[fk_index].push_back(unit);
-            else
-                unit_ptr[fa_index].push_back(unit);
-        }
-        else //treat sex n/a like it was male
-        {
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                unit_ptr[mk_index].push_back(unit);
-            else
-                unit_ptr[ma_index].push_back(unit);
-        }
-    }
-
-    void PushPriorityUnit(df::unit *unit) {
-        if(Units::isFemale(unit)) {
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                prot_ptr[fk_index].push_back(unit);
-            else
-                prot_ptr[fa_index].push_back(unit);
-        }
-        else {
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                prot_ptr[mk_index].push_back(unit);
-            else
-                prot_ptr[ma_index].push_back(unit);
-        }
-    }
-
-    void PushProtectedUnit(df::unit *unit) {
-        if(Units::isFemale(unit)) {
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                fk_prot++;
-            else
-                fa_prot++;
-        }
-        else {  //treat sex n/a like it was male
-            if(Units::isBaby(unit) || Units::isChild(unit))
-                mk_prot++;
-            else
-                ma_prot++;
+    void AddCensus(RaceCensus &census) {
+        fk_prot = census.stock_prot[fk_index];
+        mk_prot = census.stock_prot[mk_index];
+        fa_prot = census.stock_prot[fa_index];
+        ma_prot = census.stock_prot[ma_index];
+        for (size_t i = 0; i < 4; i++) {
+            unit_ptr[i].swap(census.stock[i]);
+            prot_ptr[i].swap(census.stock_priority[i]);
         }
     }
 
@@ -688,8 +667,8 @@ static bool hasValidMapPos(df::unit *unit) {
         && unit->pos.z < world->map.z_count;
 }
 
-// built cage in a zone (supposed to detect zoo cages)
-static bool isInBuiltCageRoom(df::unit *unit) {
+// ids of units assigned to built cages in a zone (supposed to detect zoo cages)
+static void getBuiltCageRoomUnits(unordered_set<int32_t> &ids) {
     for (auto building : world->buildings.all) {
         if (building->getType() != df::building_type::Cage)
             continue;
@@ -699,9 +678,8 @@ static bool isInBuiltCageRoom(df::unit *unit) {
 
         df::building_cagest* cage = (df::building_cagest*)building;
         for (auto cu : cage->assigned_units)
-            if (cu == unit->id) return true;
+            ids.insert(cu);
     }
-    return false;
 }
 
 // This can be used to identify completely inappropriate units (dead, undead, not belonging to the fort, ...)
@@ -717,19 +695,72 @@ static bool isInappropriateUnit(df::unit *unit) {
 // This can be used to identify protected units that should be counted towards fort totals, but not scheduled
 // for butchering. This way they count towards target quota, so if you order that you want 1 female adult cat
 // and have 2 cats, one of them being a pet, the other gets butchered
-static bool isProtectedUnit(df::unit *unit) {
+static bool isProtectedUnit(df::unit *unit, const unordered_set<int32_t> &cage_room_units) {
     return Units::isWar(unit)    // ignore war dogs etc
         || Units::isHunter(unit) // ignore hunting dogs etc
         || Units::isMarkedForWarTraining(unit) // ignore units marked for any kind of training
         || Units::isMarkedForHuntTraining(unit)
         // ignore creatures in built cages which are defined as rooms to leave zoos alone
         // (TODO: better solution would be to allow some kind of slaughter cages which you can place near the butcher)
-        || (isContainedInItem(unit) && isInBuiltCageRoom(unit))  // !!! see comments in isBuiltCageRoom()
+        || (isContainedInItem(unit) && cage_room_units.count(unit->id))
         || Units::isAvailableForAdoption(unit)
         || unit->name.has_name
         || !unit->name.nickname.empty();
 }
 
+static unit_ptr_index getUnitPtrIndex(df::unit *unit) {
+    bool kid = Units::isBaby(unit) || Units::isChild(unit);
+    if (Units::isFemale(unit))
+        return kid ? fk_index : fa_index;
+    //treat sex n/a like it was male
+    return kid ? mk_index : ma_index;
+}
+
+// classifies every relevant unit once, instead of walking the unit vector
+// for each race and each tally
+static void takeCensus(unordered_map<int, RaceCensus> &census) {
+    census.clear();
+
+    unordered_set<int32_t> cage_room_units;
+    getBuiltCageRoomUnits(cage_room_units);
+
+    for (auto unit : world->units.all) {
+        if (isInappropriateUnit(unit))
+            continue;
+
+        // found a bugged unit which had invalid coordinates but was not in a cage.
+        // marking it for slaughter didn't seem to have negative effects, but you never know...
+        if (!isContainedInItem(unit) && !hasValidMapPos(unit))
+            continue;
+
+        RaceCensus &c = census[unit->race];
+        unit_ptr_index idx = getUnitPtrIndex(unit);
+        bool tame = Units::isTame(unit);
+        bool prot = isProtectedUnit(unit, cage_room_units);
+        bool marked = Units::isMarkedForSlaughter(unit);
+
+        c.total[idx]++;
+        if (!tame || prot)
+            c.prot[idx]++;
+        else
+            c.butcherable[idx]++;
+        if (marked)
+            c.butcherflag[idx]++;
+
+        if (!tame || marked)
+            continue;
+        // don't butcher protected units, but count them as stock as well
+        // this way they count towards target quota, so if you order that you want 1 female adult cat
+        // and have 2 cats, one of them being a pet, the other gets butchered
+        if (prot)
+            c.stock_prot[idx]++;
+        else if (Units::isGay(unit) || Units::isGelded(unit))
+            c.stock_priority[idx].push_back(unit);
+        else
+            c.stock[idx].push_back(unit);
+    }
+}
+
 
 
 static void autobutcher_cycle(color_ostream &out) {
@@ -751,52 +782,40 @@ static void autobutcher_cycle(color_ostream &out) {
             return;
     }
 
-    for (auto unit : world->units.all) {
-        // this check is now divided into two steps, squeezed autowatch into the middle
-        // first one ignores completely inappropriate units (dead, undead, not belonging to the fort, ...)
-        // then let autowatch add units to the watchlist which will probably start breeding (owned pets, war animals, ...)
-        // then process units counting those which can't be butchered (war animals, named pets, ...)
-        // so that they are treated as "own stock" as well and count towards the target quota
-        if (isInappropriateUnit(unit)
-            || Units::isMarkedForSlaughter(unit)
-            || !Units::isTame(unit))
-            continue;
+    unordered_map<int, RaceCensus> census;
+    takeCensus(census);
 
-        // found a bugged unit which had invalid coordinates but was not in a cage.
-        // marking it for slaughter didn't seem to have negative effects, but you never know...
-        if(!isContainedInItem(unit) && !hasValidMapPos(unit))
+    for (auto &entry : census) {
+        int race = entry.first;
+        RaceCensus &c = entry.second;
+
+        // only tame units that are not yet marked for slaughter get autowatch to add their race
+        bool has_stock = false;
+        for (size_t i = 0; i < 4; i++)
+            has_stock = has_stock || c.stock_prot[i] || !c.stock[i].empty() || !c.stock_priority[i].empty();
+        if (!has_stock)
             continue;
 
         WatchedRace *w;
-        if (watched_races.count(unit->race)) {
-            w = watched_races[unit->race];
+        if (watched_races.count(race)) {
+            w = watched_races[race];
         }
         else if (!config.get_bool(CONFIG_AUTOWATCH)) {
             continue;
         }
         else {
-            w = new WatchedRace(out, unit->race, true, config.get_int(CONFIG_DEFAULT_FK),
+            w = new WatchedRace(out, race, true, config.get_int(CONFIG_DEFAULT_FK),
                 config.get_int(CONFIG_DEFAULT_MK), config.get_int(CONFIG_DEFAULT_FA),
                 config.get_int(CONFIG_DEFAULT_MA));
             w->UpdateConfig(out);
-            watched_races.emplace(unit->race, w);
+            watched_races.emplace(race, w);
 
             INFO(cycle,out).print("New race added to autobutcher watchlist: %s\n",
-                Units::getRaceNamePluralById(unit->race).c_str());
+                Units::getRaceNamePluralById(race).c_str());
         }
 
-        if (w->isWatched) {
-            // don't butcher protected units, but count them as stock as well
-            // this way they count towards target quota, so if you order that you want 1 female adult cat
-            // and have 2 cats, one of them being a pet, the other gets butchered
-            if(isProtectedUnit(unit))
-                w->PushProtectedUnit(unit);
-            else if (   Units::isGay(unit)
-                     || Units::isGelded(unit))
-                w->PushPriorityUnit(unit);
-            else
-                w->PushUnit(unit);
-        }
+        if (w->isWatched)
+            w->AddCensus(c);
     }
 
     for (auto w : watched_races) {
@@ -813,84 +832,6 @@ static void autobutcher_cycle(color_ostream &out) {
 /////////////////////////////////////
 // API functions to control autobutcher with a lua script
 
-// abuse WatchedRace struct for counting stocks (since it sorts by gender and age)
-// calling method must delete pointer!
-static WatchedRace * checkRaceStocksTotal(color_ostream &out, int race) {
-    WatchedRace * w = new WatchedRace(out, race, true, 0, 0, 0, 0);
-    for (auto unit : world->units.all) {
-        if (unit->race != race)
-            continue;
-
-        if (isInappropriateUnit(unit))
-            continue;
-
-        if(!isContainedInItem(unit) && !hasValidMapPos(unit))
-            continue;
-
-        w->PushUnit(unit);
-    }
-    return w;
-}
-
-WatchedRace * checkRaceStocksProtected(color_ostream &out, int race) {
-    WatchedRace * w = new WatchedRace(out, race, true, 0, 0, 0, 0);
-    for (auto unit : world->units.all) {
-        if (unit->race != race)
-            continue;
-
-        if (isInappropriateUnit(unit))
-            continue;
-
-        // found a bugged unit which had invalid coordinates but was not in a cage.
-        // marking it for slaughter didn't seem to have negative effects, but you never know...
-        if (!isContainedInItem(unit) && !hasValidMapPos(unit))
-            continue;
-
-        if (   !Units::isTame(unit)
-            || isProtectedUnit(unit))
-            w->PushUnit(unit);
-    }
-    return w;
-}
-
-WatchedRace * checkRaceStocksButcherable(color_ostream &out, int race) {
-    WatchedRace * w = new WatchedRace(out, race, true, 0, 0, 0, 0);
-    for (auto unit : world->units.all) {
-        if (unit->race != race)
-            continue;
-
-        if (   isInappropriateUnit(unit)
-            || !Units::isTame(unit)
-            || isProtectedUnit(unit)
-            )
-            continue;
-
-        if (!isContainedInItem(unit) && !hasValidMapPos(unit))
-            continue;
-
-        w->PushUnit(unit);
-    }
-    return w;
-}
-
-WatchedRace * checkRaceStocksButcherFlag(color_ostream &out, int race) {
-    WatchedRace * w = new WatchedRace(out, race, true, 0, 0, 0, 0);
-    for (auto unit : world->units.all) {
-        if(unit->race != race)
-            continue;
-
-        if (isInappropriateUnit(unit))
-            continue;
-
-        if (!isContainedInItem(unit) && !hasValidMapPos(unit))
-            continue;
-
-        if (Units::isMarkedForSlaughter(unit))
-            w->PushUnit(unit);
-    }
-    return w;
-}
-
 static bool autowatch_isEnabled() {
     return config.get_bool(CONFIG_AUTOWATCH);
 }
@@ -957,13 +898,16 @@ static void autobutcher_setDefaultTargetAll(color_ostream &out, unsigned fk, uns
 }
 
 static void autobutcher_butcherRace(color_ostream &out, int id) {
+    unordered_set<int32_t> cage_room_units;
+    getBuiltCageRoomUnits(cage_room_units);
+
     for (auto unit : world->units.all) {
         if(unit->race != id)
             continue;
 
         if(    isInappropriateUnit(unit)
             || !Units::isTame(unit)
-            || isProtectedUnit(unit)
+            || isProtectedUnit(unit, cage_room_units)
             )
             continue;
 
@@ -1010,9 +954,8 @@ static int autobutcher_getSettings(lua_State *L) {
 
 // push the watchlist vector as nested table on the lua stack
 static int autobutcher_getWatchList(lua_State *L) {
-    color_ostream *out = Lua::GetOutput(L);
-    if (!out)
-        out = &Core::getInstance().getConsole();
+    unordered_map<int, RaceCensus> census;
+    takeCensus(census);
 
     lua_newtable(L);
     int entry_index = 0;
@@ -1030,33 +973,26 @@ static int autobutcher_getWatchList(lua_State *L) {
         Lua::SetField(L, w->fa, ctable, "fa");
         Lua::SetField(L, w->ma, ctable, "ma");
 
-        WatchedRace *tally = checkRaceStocksTotal(*out, id);
-        Lua::SetField(L, tally->unit_ptr[fk_index].size(), ctable, "fk_total");
-        Lua::SetField(L, tally->unit_ptr[mk_index].size(), ctable, "mk_total");
-        Lua::SetField(L, tally->unit_ptr[fa_index].size(), ctable, "fa_total");
-        Lua::SetField(L, tally->unit_ptr[ma_index].size(), ctable, "ma_total");
-        delete tally;
-
-        tally = checkRaceStocksProtected(*out, id);
-        Lua::SetField(L, tally->unit_ptr[fk_index].size(), ctable, "fk_protected");
-        Lua::SetField(L, tally->unit_ptr[mk_index].size(), ctable, "mk_protected");
-        Lua::SetField(L, tally->unit_ptr[fa_index].size(), ctable, "fa_protected");
-        Lua::SetField(L, tally->unit_ptr[ma_index].size(), ctable, "ma_protected");
-        delete tally;
-
-        tally = checkRaceStocksButcherable(*out, id);
-        Lua::SetField(L, tally->unit_ptr[fk_index].size(), ctable, "fk_butcherable");
-        Lua::SetField(L, tally->unit_ptr[mk_index].size(), ctable, "mk_butcherable");
-        Lua::SetField(L, tally->unit_ptr[fa_index].size(), ctable, "fa_butcherable");
-        Lua::SetField(L, tally->unit_ptr[ma_index].size(), ctable, "ma_butcherable");
-        delete tally;
-
-        tally = checkRaceStocksButcherFlag(*out, id);
-        Lua::SetField(L, tally->unit_ptr[fk_index].size(), ctable, "fk_butcherflag");
-        Lua::SetField(L, tally->unit_ptr[mk_index].size(), ctable, "mk_butcherflag");
-        Lua::SetField(L, tally->unit_ptr[fa_index].size(), ctable, "fa_butcherflag");
-        Lua::SetField(L, tally->unit_ptr[ma_index].size(), ctable, "ma_butcherflag");
-        delete tally;
+        const RaceCensus &c = census[id];
+        Lua::SetField(L, c.total[fk_index], ctable, "fk_total");
+        Lua::SetField(L, c.total[mk_index], ctable, "mk_total");
+        Lua::SetField(L, c.total[fa_index], ctable, "fa_total");
+        Lua::SetField(L, c.total[ma_index], ctable, "ma_total");
+
+        Lua::SetField(L, c.prot[fk_index], ctable, "fk_protected");
+        Lua::SetField(L, c.prot[mk_index], ctable, "mk_protected");
+        Lua::SetField(L, c.prot[fa_index], ctable, "fa_protected");
+        Lua::SetField(L, c.prot[ma_index], ctable, "ma_protected");
+
+        Lua::SetField(L, c.butcherable[fk_index], ctable, "fk_butcherable");
+        Lua::SetField(L, c.butcherable[mk_index], ctable, "mk_butcherable");
+        Lua::SetField(L, c.butcherable[fa_index], ctable, "fa_butcherable");
+        Lua::SetField(L, c.butcherable[ma_index], ctable, "ma_butcherable");
+
+        Lua::SetField(L, c.butcherflag[fk_index], ctable, "fk_butcherflag");
+        Lua::SetField(L, c.butcherflag[mk_index], ctable, "mk_butcherflag");
+        Lua::SetField(L, c.butcherflag[fa_index], ctable, "fa_butcherflag");
+        Lua::SetField(L, c.butcherflag[ma_index], ctable, "ma_butcherflag");
 
         lua_rawseti(L, -2, ++entry_index);
     }
@@ -1,9 +1,11 @@
 #include "Debug.h"
 #include "PluginManager.h"
 
+#include "modules/Clothing.h"
 #include "modules/Items.h"
 #include "modules/Maps.h"
 #include "modules/Materials.h"
+#include "modules/Orders.h"
 #include "modules/Persistence.h"
 #include "modules/Translation.h"
 #include "modules/Units.h"
@@ -561,44 +563,28 @@ command_result autoclothing(color_ostream &out, vector <string> & parameters)
     return CR_OK;
 }
 
-static void find_needed_clothing_items()
+static void find_needed_clothing_items(const Clothing::Ledger& ledger)
 {
+    static const std::map<Clothing::SlotKey, int32_t> nothing_owned;
+
     for (auto& unit : world->units.active)
     {
         //obviously we don't care about illegal aliens.
         if (!isCitizen(unit))
             continue;
 
+        auto owned_it = ledger.owned_by_unit.find(unit->id);
+        auto& owned = owned_it == ledger.owned_by_unit.end() ? nothing_owned : owned_it->second;
+
         //now check each clothing order to see what the unit might be missing.
         for (auto& clothingOrder : clothingOrders)
         {
             int alreadyOwnedAmount = 0;
 
-            //looping through the items first, then clothing order might be a little faster, but this way is cleaner.
-            for (auto ownedItem : unit->owned_items)
+            for (auto& [slot, count] : owned)
             {
-                auto item = findItemByID(ownedItem);
-
-                if (!item)
-                {
-                    DEBUG(cycle).print("autoclothing: Invalid inventory item ID: %d\n", ownedItem);
-                    continue;
-                }
-
-                if (item->getType() != clothingOrder.itemType)
-                    continue;
-                if (item->getSubtype() != clothingOrder.item_subtype)
-                    continue;
-                if (item->getWear() >= 1)
-                    continue;
-
-                MaterialInfo matInfo;
-                matInfo.decode(item);
-
-                if (!matInfo.matches(clothingOrder.material_category))
-                    continue;
-
-                alreadyOwnedAmount++;
+                if (slot.matches(clothingOrder.itemType, clothingOrder.item_subtype, clothingOrder.material_category.whole))
+                    alreadyOwnedAmount += count;
             }
             int neededAmount = clothingOrder.needed_per_citizen - alreadyOwnedAmount;
 
@@ -611,32 +597,18 @@ static void find_needed_clothing_items()
     }
 }
 
-static void remove_available_clothing()
+static void remove_available_clothing(const Clothing::Ledger& ledger)
 {
-    for (auto& item : world->items.all)
+    //unowned items are already grouped by type, subtype, material, and maker race
+    for (auto& [slot, counts] : ledger.unowned)
     {
-        //skip any owned items.
-        if (getOwner(item))
-            continue;
-        //skip any worn or more items
-        if (item->getWear() >= 1)
+        if (!counts.good)
             continue;
 
-        //again, for each item, find if any clothing order matches
         for (auto& clothingOrder : clothingOrders)
         {
-            if (item->getType() != clothingOrder.itemType)
-                continue;
-            if (item->getSubtype() != clothingOrder.item_subtype)
-                continue;
-
-            MaterialInfo matInfo;
-            matInfo.decode(item);
-
-            if (!matInfo.matches(clothingOrder.material_category))
-                continue;
-
-            clothingOrder.total_needed_per_race[item->getMakerRace()] --;
+            if (slot.matches(clothingOrder.itemType, clothingOrder.item_subtype, clothingOrder.material_category.whole))
+                clothingOrder.total_needed_per_race[slot.race] -= counts.good;
         }
     }
 }
@@ -655,13 +627,9 @@ static void add_clothing_orders()
                 continue;
 
             bool orderExistedAlready = false;
-            for (auto& managerOrder : world->manager_orders)
+            //Annoyingly, the manager orders store the job type for clothing orders, and actual item type is left at -1;
+            for (auto& managerOrder : Orders::getOrders(clothingOrder.jobType, clothingOrder.item_subtype))
             {
-                //Annoyingly, the manager orders store the job type for clothing orders, and actual item type is left at -1;
-                if (managerOrder->job_type != clothingOrder.jobType)
-                    continue;
-                if (managerOrder->item_subtype != clothingOrder.item_subtype)
-                    continue;
                 if (managerOrder->hist_figure_id != race)
                     continue;
 
@@ -687,7 +655,7 @@ static void add_clothing_orders()
                 newOrder->material_category = clothingOrder.material_category;
                 newOrder->amount_left = amount;
                 newOrder->amount_total = amount;
-                world->manager_orders.push_back(newOrder);
+                Orders::addOrder(newOrder);
             }
         }
     }
@@ -701,11 +669,13 @@ static void do_autoclothing()
     if (clothingOrders.size() == 0)
         return;
 
+    auto& ledger = Clothing::getLedger();
+
     //first we look through all the units on the map to see who needs new clothes.
-    find_needed_clothing_items();
+    find_needed_clothing_items(ledger);
 
     //Now we go through all the items in the map to see how many clothing items we have but aren't owned yet.
-    remove_available_clothing();
+    remove_available_clothing(ledger);
 
     //Finally loop through the clothing orders to find ones that need more made.
     add_clothing_orders();
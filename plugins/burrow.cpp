@@ -287,68 +287,10 @@ static df::burrow* get_burrow(lua_State *L, int idx) {
 }
 
 static void copyTiles(df::burrow *target, df::burrow *source, bool enable) {
-    CHECK_NULL_POINTER(target);
-    CHECK_NULL_POINTER(source);
-
-    if (source == target) {
-        if (!enable)
-            Burrows::clearTiles(target);
-        return;
-    }
-
-    vector<df::map_block*> pvec;
-    Burrows::listBlocks(&pvec, source);
-
-    for (auto block : pvec) {
-        auto smask = Burrows::getBlockMask(source, block);
-        if (!smask)
-            continue;
-
-        auto tmask = Burrows::getBlockMask(target, block, enable);
-        if (!tmask)
-            continue;
-
-        if (enable) {
-            for (int j = 0; j < 16; j++)
-                tmask->tile_bitmask[j] |= smask->tile_bitmask[j];
-        } else {
-            for (int j = 0; j < 16; j++)
-                tmask->tile_bitmask[j] &= ~smask->tile_bitmask[j];
-
-            if (!tmask->has_assignments())
-                Burrows::deleteBlockMask(target, block, tmask);
-        }
-    }
-}
-
-static void setTilesByDesignation(df::burrow *target, df::tile_designation d_mask,
-                                  df::tile_designation d_value, bool enable) {
-    CHECK_NULL_POINTER(target);
-
-    auto &blocks = world->map.map_blocks;
-
-    for (auto block : blocks) {
-        df::block_burrow *mask = NULL;
-
-        for (int x = 0; x < 16; x++) {
-            for (int y = 0; y < 16; y++) {
-                if ((block->designation[x][y].whole & d_mask.whole) != d_value.whole)
-                    continue;
-
-                if (!mask)
-                    mask = Burrows::getBlockMask(target, block, enable);
-                if (!mask)
-                    goto next_block;
-
-                mask->setassignment(x, y, enable);
-            }
-        }
-
-        if (mask && !enable && !mask->has_assignments())
-            Burrows::deleteBlockMask(target, block, mask);
-
-    next_block:;
-    }
+    if (enable)
+        Burrows::unionTiles(target, source);
+    else
+        Burrows::subtractTiles(target, source);
 }
 
 static bool setTilesByKeyword(df::burrow *target, std::string name, bool enable) {
@@ -376,7 +318,7 @@ static bool setTilesByKeyword(df::burrow *target, std::string name, bool enable)
     else
         return false;
 
-    setTilesByDesignation(target, mask, value, enable);
+    Burrows::setTilesByDesignation(target, mask, value, enable);
     return true;
 }
 
@@ -473,14 +415,7 @@ static void box_fill(lua_State *L, bool enable) {
         return;
     }
 
-    for (int32_t z = pos_start.z; z <= pos_end.z; ++z) {
-        for (int32_t y = pos_start.y; y <= pos_end.y; ++y) {
-            for (int32_t x = pos_start.x; x <= pos_end.x; ++x) {
-                df::coord pos(x, y, z);
-                Burrows::setAssignedTile(burrow, pos, enable);
-            }
-        }
-    }
+    Burrows::setTilesInBox(burrow, pos_start, pos_end, enable);
 }
 
 static int burrow_tiles_box_add(lua_State *L) {
@@ -571,6 +506,7 @@ static void flood_fill(lua_State *L, bool enable) {
     DEBUG(status).print("starting pos: (%d,%d,%d); outside: %d; hidden: %d\n",
         start_pos.x, start_pos.y, start_pos.z, start_outside, start_hidden);
 
+    Burrows::BlockMaskCache burrow_tiles(burrow);
     std::stack<df::coord> flood;
     flood.emplace(start_pos);
 
@@ -592,10 +528,10 @@ static void flood_fill(lua_State *L, bool enable) {
         if (!start_walk && walk)
             continue;
 
-        if (pos != start_pos && enable == Burrows::isAssignedTile(burrow, pos))
+        if (pos != start_pos && enable == burrow_tiles.isAssignedTile(pos))
             continue;
 
-        Burrows::setAssignedTile(burrow, pos, enable);
+        burrow_tiles.setAssignedTile(pos, enable);
 
         // only go one tile outside of a walkability group (trees don't count)
         df::tiletype *tt = Maps::getTileType(pos);
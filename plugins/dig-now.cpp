@@ -29,6 +29,7 @@
 #include <df/world.h>
 #include <df/world_site.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <unordered_set>
 #include <unordered_map>
@@ -149,6 +150,14 @@ public:
     bool count(const df::coord &pos) {
         return jobs.count(pos);
     }
+    // designation jobs clear the tile designation, so the blocks they are in
+    // may not be flagged as designated
+    void add_blocks(std::unordered_set<df::map_block *> &blocks) {
+        for (auto &entry : jobs) {
+            if (auto block = Maps::getTileBlock(entry.first))
+                blocks.emplace(block);
+        }
+    }
 };
 
 struct boulder_percent_options {
@@ -750,16 +759,34 @@ static void do_dig(color_ostream &out, std::vector<DFCoord> &dug_coords,
     rng.init();
 
     DEBUG(general).print("do_dig(): reading map..\n");
-    std::unordered_set<designation> buffer;
+    // only blocks with designations or designation jobs can have work for us
+    std::unordered_set<df::map_block *> block_set;
+    jobs.add_blocks(block_set);
+    Maps::forEachDesignatedBlock([&](df::map_block *block, const Maps::DesignationCounts &) {
+        block_set.emplace(block);
+    });
+    std::vector<df::map_block *> blocks(block_set.begin(), block_set.end());
     // go down levels instead of up so stacked ramps behave as expected
-    for (int16_t z = options.end.z; z >= options.start.z; --z) {
-        for (int16_t y = options.start.y; y <= options.end.y; ++y) {
-            for (int16_t x = options.start.x; x <= options.end.x; ++x) {
-                // this will return NULL if the map block hasn't been allocated
-                // yet, but that means there aren't any designations anyway.
-                if (!Maps::getTileBlock(x, y, z))
-                    continue;
+    std::sort(blocks.begin(), blocks.end(), [](df::map_block *a, df::map_block *b) {
+        if (a->map_pos.z != b->map_pos.z)
+            return a->map_pos.z > b->map_pos.z;
+        if (a->map_pos.y != b->map_pos.y)
+            return a->map_pos.y < b->map_pos.y;
+        return a->map_pos.x < b->map_pos.x;
+    });
 
+    std::unordered_set<designation> buffer;
+    for (auto block : blocks) {
+        const df::coord &origin = block->map_pos;
+        int16_t z = origin.z;
+        if (z < options.start.z || z > options.end.z)
+            continue;
+        int16_t x_start = std::max<int16_t>(options.start.x, origin.x);
+        int16_t x_end = std::min<int16_t>(options.end.x, origin.x + 15);
+        int16_t y_start = std::max<int16_t>(options.start.y, origin.y);
+        int16_t y_end = std::min<int16_t>(options.end.y, origin.y + 15);
+        for (int16_t y = y_start; y <= y_end; ++y) {
+            for (int16_t x = x_start; x <= x_end; ++x) {
                 DFCoord pos(x, y, z);
                 df::tile_designation td = map.designationAt(pos);
                 df::tile_occupancy to = map.occupancyAt(pos);
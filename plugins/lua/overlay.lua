@@ -69,6 +69,8 @@ function register_trigger_lock_screen(scr, desc)
         trigger_lock_holder_description = nil
     end
     trigger_lock_holder_screen = scr
+    -- keep the logic hooks calling in while the lock needs to be checked
+    overlay_setTriggerLockHeld(not not scr)
     if trigger_lock_holder_screen then
         trigger_lock_holder_description = desc
         return true
@@ -86,6 +88,16 @@ local function triggered_screen_has_lock()
     return register_trigger_lock_screen(nil, nil)
 end
 
+-- tell the C++ hooks which viewscreens have enabled widgets so they can skip
+-- calling into Lua on all the others
+local function publish_active_viewscreens()
+    local vs_names = {}
+    for vs_name in pairs(active_viewscreen_widgets) do
+        table.insert(vs_names, vs_name)
+    end
+    overlay_setActiveViewscreens(vs_names)
+end
+
 local function reset()
     register_trigger_lock_screen(nil, nil)
 
@@ -97,6 +109,7 @@ local function reset()
 
     active_hotspot_widgets = {}
     active_viewscreen_widgets = {}
+    publish_active_viewscreens()
 end
 
 local function save_config()
@@ -210,6 +223,7 @@ local function do_enable(args, quiet, skip_save)
     else
         do_by_names_or_numbers(args, enable_fn)
     end
+    publish_active_viewscreens()
     if not skip_save then
         save_config()
     end
@@ -241,6 +255,7 @@ local function do_disable(args, quiet)
     else
         do_by_names_or_numbers(args, disable_fn)
     end
+    publish_active_viewscreens()
     save_config()
 end
 
@@ -568,15 +583,9 @@ local function _render_viewscreen_widgets(vs_name, vs, dc)
     return dc
 end
 
-local force_refresh
-
 function render_viewscreen_widgets(vs_name, vs)
     local dc = _render_viewscreen_widgets(vs_name, vs, nil)
     _render_viewscreen_widgets('all', nil, dc)
-    if force_refresh then
-        force_refresh = nil
-        df.global.gps.force_full_display_count = 1
-    end
 end
 
 -- called when the DF window is resized
@@ -585,7 +594,8 @@ function reposition_widgets()
     for _,db_entry in pairs(widget_db) do
         db_entry.widget:updateLayout(sr)
     end
-    force_refresh = true
+    -- the C++ render hook forces the redraw, even on screens without widgets
+    overlay_requestRefresh()
 end
 
 -- ------------------------------------------------- --
@@ -6,6 +6,7 @@
 
 #include "modules/Filesystem.h"
 #include "modules/Materials.h"
+#include "modules/Orders.h"
 #include "modules/World.h"
 
 #include "json/json.h"
@@ -908,7 +909,7 @@ static command_result orders_import(color_ostream &out, Json::Value &orders)
 
         // TODO: items
 
-        world->manager_orders.push_back(order);
+        Orders::addOrder(order);
     }
 
     return CR_OK;
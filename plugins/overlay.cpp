@@ -1,4 +1,5 @@
 #include "df/enabler.h"
+#include "df/graphic.h"
 #include "df/viewscreen_adopt_regionst.h"
 #include "df/viewscreen_choose_game_typest.h"
 #include "df/viewscreen_choose_start_sitest.h"
@@ -25,6 +26,9 @@
 #include "modules/Gui.h"
 #include "modules/Screen.h"
 
+#include <string>
+#include <vector>
+
 using namespace DFHack;
 
 DFHACK_PLUGIN("overlay");
@@ -32,6 +36,7 @@ DFHACK_PLUGIN_IS_ENABLED(is_enabled);
 
 REQUIRE_GLOBAL(world);
 REQUIRE_GLOBAL(enabler);
+REQUIRE_GLOBAL(gps);
 
 namespace DFHack {
     DBG_DECLARE(overlay, control, DebugCategory::LINFO);
@@ -40,11 +45,49 @@ namespace DFHack {
 
 static df::coord2d screenSize;
 
-static void call_overlay_lua(color_ostream *out, const char *fn_name,
+// Lua entry points into plugins.overlay. Each is resolved from the module the
+// first time it is called and then kept in the registry, keyed by the address
+// of its descriptor, so the per-frame hooks don't have to go through require.
+struct OverlayFunction {
+    const char *name;
+    bool cached;
+};
+
+static OverlayFunction fn_update_viewscreen_widgets = {"update_viewscreen_widgets", false};
+static OverlayFunction fn_feed_viewscreen_widgets = {"feed_viewscreen_widgets", false};
+static OverlayFunction fn_render_viewscreen_widgets = {"render_viewscreen_widgets", false};
+static OverlayFunction fn_update_hotspot_widgets = {"update_hotspot_widgets", false};
+static OverlayFunction fn_reposition_widgets = {"reposition_widgets", false};
+static OverlayFunction fn_rescan = {"rescan", false};
+static OverlayFunction fn_overlay_command = {"overlay_command", false};
+
+static OverlayFunction *const overlay_functions[] = {
+    &fn_update_viewscreen_widgets, &fn_feed_viewscreen_widgets, &fn_render_viewscreen_widgets,
+    &fn_update_hotspot_widgets, &fn_reposition_widgets, &fn_rescan, &fn_overlay_command,
+};
+
+// forget cached functions so a reloaded module is picked up
+static void clear_overlay_functions() {
+    for (auto fn : overlay_functions)
+        fn->cached = false;
+}
+
+static bool push_overlay_function(color_ostream &out, lua_State *L, OverlayFunction &fn) {
+    if (!fn.cached) {
+        if (!Lua::PushModulePublic(out, L, "plugins.overlay", fn.name))
+            return false;
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &fn);
+        fn.cached = true;
+    }
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &fn);
+    return true;
+}
+
+static void call_overlay_lua(color_ostream *out, OverlayFunction &fn,
         int nargs = 0, int nres = 0,
         Lua::LuaLambda && args_lambda = Lua::DEFAULT_LUA_LAMBDA,
         Lua::LuaLambda && res_lambda = Lua::DEFAULT_LUA_LAMBDA) {
-    DEBUG(event).print("calling overlay lua function: '%s'\n", fn_name);
+    DEBUG(event).print("calling overlay lua function: '%s'\n", fn.name);
 
     CoreSuspender guard;
 
@@ -54,18 +97,95 @@ static void call_overlay_lua(color_ostream *out, const char *fn_name,
     if (!out)
         out = &Core::getInstance().getConsole();
 
-    Lua::CallLuaModuleFunction(*out, L, "plugins.overlay", fn_name, nargs, nres,
-                               std::forward<Lua::LuaLambda&&>(args_lambda),
-                               std::forward<Lua::LuaLambda&&>(res_lambda));
+    if (!lua_checkstack(L, 1 + nargs) || !push_overlay_function(*out, L, fn)) {
+        out->printerr("Failed to load plugins.overlay Lua code\n");
+        return;
+    }
+
+    std::forward<Lua::LuaLambda&&>(args_lambda)(L);
+
+    if (!Lua::SafeCall(*out, L, nargs, nres)) {
+        out->printerr("Failed Lua call to 'plugins.overlay.%s'\n", fn.name);
+        return;
+    }
+
+    std::forward<Lua::LuaLambda&&>(res_lambda)(L);
+}
+
+// Bitmap of the hooked viewscreens that have at least one enabled widget, as
+// published by the Lua side. The hooks skip calling into Lua entirely for
+// screens whose bit is clear.
+static const uint32_t ALL_SCREENS_BIT = 1u << 31;
+static uint32_t active_screens = 0;
+
+static std::vector<std::string> &get_hooked_screens() {
+    static std::vector<std::string> hooked_screens;
+    return hooked_screens;
+}
+
+static uint32_t register_hooked_screen(const char *name) {
+    auto &hooked_screens = get_hooked_screens();
+    hooked_screens.emplace_back(name);
+    // out of bits; such screens always call into Lua
+    if (hooked_screens.size() > 31)
+        return ALL_SCREENS_BIT;
+    return 1u << (hooked_screens.size() - 1);
+}
+
+static int overlay_setActiveViewscreens(lua_State *L) {
+    std::vector<std::string> vs_names;
+    Lua::GetVector(L, vs_names);
+
+    auto &hooked_screens = get_hooked_screens();
+    uint32_t mask = 0;
+    for (auto &vs_name : vs_names) {
+        if (vs_name == "all") {
+            mask |= ALL_SCREENS_BIT;
+            continue;
+        }
+        for (size_t idx = 0; idx < hooked_screens.size(); ++idx) {
+            if (hooked_screens[idx] == vs_name)
+                mask |= 1u << idx;
+        }
+    }
+    DEBUG(control).print("active viewscreen mask: 0x%08x\n", mask);
+    active_screens = mask;
+    return 0;
+}
+
+// While a triggered screen holds the lock, the logic hooks must keep calling
+// into Lua so the lock is released once that screen goes away.
+static bool trigger_lock_held = false;
+
+static int overlay_setTriggerLockHeld(lua_State *L) {
+    trigger_lock_held = lua_toboolean(L, 1);
+    return 0;
+}
+
+// Set when widgets are repositioned; the next render of any hooked screen,
+// with or without widgets, forces a full redraw.
+static bool force_refresh = false;
+
+static int overlay_requestRefresh(lua_State *L) {
+    force_refresh = true;
+    return 0;
 }
 
 template<class T>
 struct viewscreen_overlay : T {
     typedef T interpose_base;
 
+    static const uint32_t screen_bit;
+
+    static bool has_widgets() {
+        return active_screens & (screen_bit | ALL_SCREENS_BIT);
+    }
+
     DEFINE_VMETHOD_INTERPOSE(void, logic, ()) {
         INTERPOSE_NEXT(logic)();
-        call_overlay_lua(NULL, "update_viewscreen_widgets", 2, 0,
+        if (!has_widgets() && !trigger_lock_held)
+            return;
+        call_overlay_lua(NULL, fn_update_viewscreen_widgets, 2, 0,
                 [&](lua_State *L) {
                     Lua::Push(L, T::_identity.getName());
                     Lua::Push(L, this);
@@ -74,8 +194,8 @@ struct viewscreen_overlay : T {
     DEFINE_VMETHOD_INTERPOSE(void, feed, (std::set<df::interface_key> *input)) {
         bool input_is_handled = false;
         // don't send input to the overlays if there is a modal dialog up
-        if (!world->status.popups.size())
-            call_overlay_lua(NULL, "feed_viewscreen_widgets", 3, 1,
+        if (has_widgets() && !world->status.popups.size())
+            call_overlay_lua(NULL, fn_feed_viewscreen_widgets, 3, 1,
                     [&](lua_State *L) {
                         Lua::Push(L, T::_identity.getName());
                         Lua::Push(L, this);
@@ -90,16 +210,23 @@ struct viewscreen_overlay : T {
     }
     DEFINE_VMETHOD_INTERPOSE(void, render, ()) {
         INTERPOSE_NEXT(render)();
-        call_overlay_lua(NULL, "render_viewscreen_widgets", 2, 0,
-                [&](lua_State *L) {
-                    Lua::Push(L, T::_identity.getName());
-                    Lua::Push(L, this);
-                });
+        if (has_widgets())
+            call_overlay_lua(NULL, fn_render_viewscreen_widgets, 2, 0,
+                    [&](lua_State *L) {
+                        Lua::Push(L, T::_identity.getName());
+                        Lua::Push(L, this);
+                    });
+        if (force_refresh) {
+            force_refresh = false;
+            gps->force_full_display_count = 1;
+        }
     }
 };
 
 #define IMPLEMENT_HOOKS(screen) \
     typedef viewscreen_overlay<df::viewscreen_##screen##st> screen##_overlay; \
+    template<> const uint32_t screen##_overlay::screen_bit = \
+        register_hooked_screen("viewscreen_" #screen "st"); \
     template<> IMPLEMENT_VMETHOD_INTERPOSE_PRIO(screen##_overlay, logic, 100); \
     template<> IMPLEMENT_VMETHOD_INTERPOSE_PRIO(screen##_overlay, feed, 100); \
     template<> IMPLEMENT_VMETHOD_INTERPOSE_PRIO(screen##_overlay, render, 100);
@@ -134,7 +261,8 @@ DFhackCExport command_result plugin_enable(color_ostream &out, bool enable) {
 
     if (enable) {
         screenSize = Screen::getWindowSize();
-        call_overlay_lua(&out, "rescan");
+        clear_overlay_functions();
+        call_overlay_lua(&out, fn_rescan);
     }
 
     DEBUG(control).print("%sing interpose hooks\n", enable ? "enabl" : "disabl");
@@ -165,7 +293,7 @@ DFhackCExport command_result plugin_enable(color_ostream &out, bool enable) {
 
 static command_result overlay_cmd(color_ostream &out, std::vector <std::string> & parameters) {
     bool show_help = false;
-    call_overlay_lua(&out, "overlay_command", 1, 1, [&](lua_State *L) {
+    call_overlay_lua(&out, fn_overlay_command, 1, 1, [&](lua_State *L) {
             Lua::PushVector(L, parameters);
         }, [&](lua_State *L) {
             show_help = !lua_toboolean(L, -1);
@@ -192,9 +320,16 @@ DFhackCExport command_result plugin_shutdown(color_ostream &out) {
 DFhackCExport command_result plugin_onupdate (color_ostream &out) {
     df::coord2d newScreenSize = Screen::getWindowSize();
     if (newScreenSize != screenSize) {
-        call_overlay_lua(&out, "reposition_widgets");
+        call_overlay_lua(&out, fn_reposition_widgets);
         screenSize = newScreenSize;
     }
-    call_overlay_lua(&out, "update_hotspot_widgets");
+    call_overlay_lua(&out, fn_update_hotspot_widgets);
     return CR_OK;
 }
+
+DFHACK_PLUGIN_LUA_COMMANDS {
+    DFHACK_LUA_COMMAND(overlay_setActiveViewscreens),
+    DFHACK_LUA_COMMAND(overlay_setTriggerLockHeld),
+    DFHACK_LUA_COMMAND(overlay_requestRefresh),
+    DFHACK_LUA_END
+};
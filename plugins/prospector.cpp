@@ -9,6 +9,7 @@
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <memory>
 #include <algorithm>
 #include <functional>
 #include <vector>
@@ -120,6 +121,14 @@ struct matdata
         }
         return count;
     }
+    void merge(const matdata &other)
+    {
+        count += other.count;
+        if (other.lower_z != invalid_z && (lower_z == invalid_z || other.lower_z < lower_z))
+            lower_z = other.lower_z;
+        if (other.upper_z != invalid_z && (upper_z == invalid_z || other.upper_z > upper_z))
+            upper_z = other.upper_z;
+    }
     float count;
     int lower_z;
     int upper_z;
@@ -620,22 +629,11 @@ static command_result embark_prospector(color_ostream &out,
     return CR_OK;
 }
 
-static command_result map_prospector(color_ostream &con,
-                                     const prospect_options &options) {
-    if (!Maps::IsValid())
-    {
-        con.printerr("Map is not available!\n");
-        return CR_FAILURE;
-    }
-
-    uint32_t x_max = 0, y_max = 0, z_max = 0;
-    Maps::getSize(x_max, y_max, z_max);
-    MapExtras::MapCache map;
-
-    DFHack::Materials *mats = Core::getInstance().getMaterials();
-
-    DFHack::t_feature blockFeatureGlobal;
-    DFHack::t_feature blockFeatureLocal;
+// Per-worker totals for map_prospector; each worker scans its blocks through
+// its own MapCache and the totals are merged once the scan is done.
+struct ProspectState
+{
+    std::unique_ptr<MapExtras::MapCache> map;
 
     bool hasDemonTemple = false;
     bool hasLair = false;
@@ -650,162 +648,217 @@ static command_result map_prospector(color_ostream &con,
     matdata aquiferTiles;
     matdata tubeTiles;
 
-    for(uint32_t z = 0; z < z_max; z++)
+    static void merge(MatMap &into, const MatMap &from)
+    {
+        for (auto &entry : from)
+            into[entry.first].merge(entry.second);
+    }
+
+    void merge(const ProspectState &other)
+    {
+        hasDemonTemple = hasDemonTemple || other.hasDemonTemple;
+        hasLair = hasLair || other.hasLair;
+        merge(baseMats, other.baseMats);
+        merge(layerMats, other.layerMats);
+        merge(veinMats, other.veinMats);
+        merge(plantMats, other.plantMats);
+        merge(treeMats, other.treeMats);
+        liquidWater.merge(other.liquidWater);
+        liquidMagma.merge(other.liquidMagma);
+        aquiferTiles.merge(other.aquiferTiles);
+        tubeTiles.merge(other.tubeTiles);
+    }
+};
+
+static void prospect_block(ProspectState &st, df::map_block *block,
+                           const prospect_options &options)
+{
+    DFHack::DFCoord bcoord(block->map_pos.x >> 4, block->map_pos.y >> 4, block->map_pos.z);
+    MapExtras::Block *b = st.map->BlockAt(bcoord);
+    if (!b || !b->is_valid())
     {
-        // the '- 100' is because DF v50 and later have a 100 offset in reported elevation
-        int global_z = world->map.region_z + z - 100;
+        return;
+    }
 
-        for(uint32_t b_y = 0; b_y < y_max; b_y++)
+    // the '- 100' is because DF v50 and later have a 100 offset in reported elevation
+    int global_z = world->map.region_z + bcoord.z - 100;
+
+    DFHack::t_feature blockFeatureGlobal;
+    DFHack::t_feature blockFeatureLocal;
+
+    // Find features
+    b->GetGlobalFeature(&blockFeatureGlobal);
+    b->GetLocalFeature(&blockFeatureLocal);
+
+    // Iterate over all the tiles in the block
+    for(uint32_t y = 0; y < 16; y++)
+    {
+        for(uint32_t x = 0; x < 16; x++)
         {
-            for(uint32_t b_x = 0; b_x < x_max; b_x++)
+            df::coord2d coord(x, y);
+            df::tile_designation des = b->DesignationAt(coord);
+            df::tile_occupancy occ = b->OccupancyAt(coord);
+
+            // Skip hidden tiles
+            if (!options.hidden && des.bits.hidden)
+            {
+                continue;
+            }
+
+            // Check for aquifer
+            if (des.bits.water_table)
+            {
+                st.aquiferTiles.add(global_z);
+            }
+
+            // Check for lairs
+            if (occ.bits.monster_lair)
             {
-                // Get the map block
-                df::coord2d blockCoord(b_x, b_y);
-                MapExtras::Block *b = map.BlockAt(DFHack::DFCoord(b_x, b_y, z));
-                if (!b || !b->is_valid())
+                st.hasLair = true;
+            }
+
+            // Check for liquid
+            if (des.bits.flow_size)
+            {
+                if (des.bits.liquid_type == tile_liquid::Magma)
+                    st.liquidMagma.add(global_z);
+                else
+                    st.liquidWater.add(global_z);
+            }
+
+            df::tiletype type = b->tiletypeAt(coord);
+            df::tiletype_shape tileshape = tileShape(type);
+            df::tiletype_material tilemat = tileMaterial(type);
+
+            // We only care about these types
+            switch (tileshape)
+            {
+            case tiletype_shape::WALL:
+            case tiletype_shape::FORTIFICATION:
+                break;
+            case tiletype_shape::EMPTY:
+                /* A heuristic: tubes inside adamantine have EMPTY:AIR tiles which
+                   still have feature_local set. Also check the unrevealed status,
+                   so as to exclude any holes mined by the player. */
+                if (tilemat == tiletype_material::AIR &&
+                    des.bits.feature_local && des.bits.hidden &&
+                    blockFeatureLocal.type == feature_type::deep_special_tube)
                 {
-                    continue;
+                    st.tubeTiles.add(global_z);
                 }
+            default:
+                continue;
+            }
 
-                // Find features
-                b->GetGlobalFeature(&blockFeatureGlobal);
-                b->GetLocalFeature(&blockFeatureLocal);
+            // Count the material type
+            st.baseMats[tilemat].add(global_z);
 
-                // Iterate over all the tiles in the block
-                for(uint32_t y = 0; y < 16; y++)
+            // Find the type of the tile
+            switch (tilemat)
+            {
+            case tiletype_material::SOIL:
+            case tiletype_material::STONE:
+                st.layerMats[b->layerMaterialAt(coord)].add(global_z);
+                break;
+            case tiletype_material::MINERAL:
+                st.veinMats[b->veinMaterialAt(coord)].add(global_z);
+                break;
+            case tiletype_material::FEATURE:
+                if (blockFeatureLocal.type != -1 && des.bits.feature_local)
                 {
-                    for(uint32_t x = 0; x < 16; x++)
+                    if (blockFeatureLocal.type == feature_type::deep_special_tube
+                            && blockFeatureLocal.main_material == 0) // stone
+                    {
+                        st.veinMats[blockFeatureLocal.sub_material].add(global_z);
+                    }
+                    else if (blockFeatureLocal.type == feature_type::deep_surface_portal)
                     {
-                        df::coord2d coord(x, y);
-                        df::tile_designation des = b->DesignationAt(coord);
-                        df::tile_occupancy occ = b->OccupancyAt(coord);
-
-                        // Skip hidden tiles
-                        if (!options.hidden && des.bits.hidden)
-                        {
-                            continue;
-                        }
-
-                        // Check for aquifer
-                        if (des.bits.water_table)
-                        {
-                            aquiferTiles.add(global_z);
-                        }
-
-                        // Check for lairs
-                        if (occ.bits.monster_lair)
-                        {
-                            hasLair = true;
-                        }
-
-                        // Check for liquid
-                        if (des.bits.flow_size)
-                        {
-                            if (des.bits.liquid_type == tile_liquid::Magma)
-                                liquidMagma.add(global_z);
-                            else
-                                liquidWater.add(global_z);
-                        }
-
-                        df::tiletype type = b->tiletypeAt(coord);
-                        df::tiletype_shape tileshape = tileShape(type);
-                        df::tiletype_material tilemat = tileMaterial(type);
-
-                        // We only care about these types
-                        switch (tileshape)
-                        {
-                        case tiletype_shape::WALL:
-                        case tiletype_shape::FORTIFICATION:
-                            break;
-                        case tiletype_shape::EMPTY:
-                            /* A heuristic: tubes inside adamantine have EMPTY:AIR tiles which
-                               still have feature_local set. Also check the unrevealed status,
-                               so as to exclude any holes mined by the player. */
-                            if (tilemat == tiletype_material::AIR &&
-                                des.bits.feature_local && des.bits.hidden &&
-                                blockFeatureLocal.type == feature_type::deep_special_tube)
-                            {
-                                tubeTiles.add(global_z);
-                            }
-                        default:
-                            continue;
-                        }
-
-                        // Count the material type
-                        baseMats[tilemat].add(global_z);
-
-                        // Find the type of the tile
-                        switch (tilemat)
-                        {
-                        case tiletype_material::SOIL:
-                        case tiletype_material::STONE:
-                            layerMats[b->layerMaterialAt(coord)].add(global_z);
-                            break;
-                        case tiletype_material::MINERAL:
-                            veinMats[b->veinMaterialAt(coord)].add(global_z);
-                            break;
-                        case tiletype_material::FEATURE:
-                            if (blockFeatureLocal.type != -1 && des.bits.feature_local)
-                            {
-                                if (blockFeatureLocal.type == feature_type::deep_special_tube
-                                        && blockFeatureLocal.main_material == 0) // stone
-                                {
-                                    veinMats[blockFeatureLocal.sub_material].add(global_z);
-                                }
-                                else if (blockFeatureLocal.type == feature_type::deep_surface_portal)
-                                {
-                                    hasDemonTemple = true;
-                                }
-                            }
-
-                            if (blockFeatureGlobal.type != -1 && des.bits.feature_global
-                                    && blockFeatureGlobal.type == feature_type::underworld_from_layer
-                                    && blockFeatureGlobal.main_material == 0) // stone
-                            {
-                                layerMats[blockFeatureGlobal.sub_material].add(global_z);
-                            }
-                            break;
-                        case tiletype_material::LAVA_STONE:
-                            // TODO ?
-                            break;
-                        default:
-                            break;
-                        }
+                        st.hasDemonTemple = true;
                     }
                 }
 
-                // Check plants this way, as the other way wasn't getting them all
-                // and we can check visibility more easily here
-                if (options.shrubs)
+                if (blockFeatureGlobal.type != -1 && des.bits.feature_global
+                        && blockFeatureGlobal.type == feature_type::underworld_from_layer
+                        && blockFeatureGlobal.main_material == 0) // stone
                 {
-                    auto block = Maps::getBlockColumn(b_x,b_y);
-                    vector<df::plant *> *plants = block ? &block->plants : NULL;
-                    if(plants)
-                    {
-                        for (PlantList::const_iterator it = plants->begin(); it != plants->end(); it++)
-                        {
-                            const df::plant & plant = *(*it);
-                            if (uint32_t(plant.pos.z) != z)
-                                continue;
-                            df::coord2d loc(plant.pos.x, plant.pos.y);
-                            loc = loc % 16;
-                            if (options.hidden || !b->DesignationAt(loc).bits.hidden)
-                            {
-                                if(plant.flags.bits.is_shrub)
-                                    plantMats[plant.material].add(global_z);
-                                else
-                                    treeMats[plant.material].add(global_z);
-                            }
-                        }
-                    }
+                    st.layerMats[blockFeatureGlobal.sub_material].add(global_z);
                 }
-                // Block end
-            } // block x
+                break;
+            case tiletype_material::LAVA_STONE:
+                // TODO ?
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    // Check plants this way, as the other way wasn't getting them all
+    // and we can check visibility more easily here
+    if (options.shrubs)
+    {
+        auto column = Maps::getBlockColumn(bcoord.x, bcoord.y);
+        vector<df::plant *> *plants = column ? &column->plants : NULL;
+        if(plants)
+        {
+            for (PlantList::const_iterator it = plants->begin(); it != plants->end(); it++)
+            {
+                const df::plant & plant = *(*it);
+                if (plant.pos.z != bcoord.z)
+                    continue;
+                df::coord2d loc(plant.pos.x, plant.pos.y);
+                loc = loc % 16;
+                if (options.hidden || !b->DesignationAt(loc).bits.hidden)
+                {
+                    if(plant.flags.bits.is_shrub)
+                        st.plantMats[plant.material].add(global_z);
+                    else
+                        st.treeMats[plant.material].add(global_z);
+                }
+            }
+        }
+    }
+
+    // Clean uneeded memory
+    st.map->discardBlock(b);
+}
+
+static command_result map_prospector(color_ostream &con,
+                                     const prospect_options &options) {
+    if (!Maps::IsValid())
+    {
+        con.printerr("Map is not available!\n");
+        return CR_FAILURE;
+    }
+
+    DFHack::Materials *mats = Core::getInstance().getMaterials();
 
-            // Clean uneeded memory
-            map.trash();
-        } // block y
-    } // z
+    // MapCache reads the geology when it is constructed, so build one per
+    // worker here rather than on the worker threads
+    std::vector<ProspectState> states(Maps::getParallelWorkerCount());
+    for (auto &st : states)
+        st.map.reset(new MapExtras::MapCache());
+
+    Maps::parallelForEachBlock([&](df::map_block *block, size_t worker) {
+        prospect_block(states[worker], block, options);
+    });
+
+    for (size_t i = 1; i < states.size(); i++)
+        states[0].merge(states[i]);
+    states.resize(1);
+
+    bool hasDemonTemple = states[0].hasDemonTemple;
+    bool hasLair = states[0].hasLair;
+    MatMap &baseMats = states[0].baseMats;
+    MatMap &layerMats = states[0].layerMats;
+    MatMap &veinMats = states[0].veinMats;
+    MatMap &plantMats = states[0].plantMats;
+    MatMap &treeMats = states[0].treeMats;
+
+    matdata &liquidWater = states[0].liquidWater;
+    matdata &liquidMagma = states[0].liquidMagma;
+    matdata &aquiferTiles = states[0].aquiferTiles;
+    matdata &tubeTiles = states[0].tubeTiles;
 
     MatMap::const_iterator it;
 
@@ -3,6 +3,8 @@
 
 #include <cstdio>
 #include <time.h>
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 #include "Console.h"
@@ -149,14 +151,12 @@ REQUIRE_GLOBAL(adventure);
 static command_result GetGrowthList(color_ostream &stream, const EmptyMessage *in, MaterialList *out);
 static command_result GetMaterialList(color_ostream &stream, const EmptyMessage *in, MaterialList *out);
 static command_result GetTiletypeList(color_ostream &stream, const EmptyMessage *in, TiletypeList *out);
-static command_result GetBlockList(color_ostream &stream, const BlockRequest *in, BlockList *out);
 static command_result GetPlantList(color_ostream &stream, const BlockRequest *in, PlantList *out);
 static command_result CheckHashes(color_ostream &stream, const EmptyMessage *in);
 static command_result GetUnitList(color_ostream &stream, const EmptyMessage *in, UnitList *out);
 static command_result GetUnitListInside(color_ostream &stream, const BlockRequest *in, UnitList *out);
 static command_result GetViewInfo(color_ostream &stream, const EmptyMessage *in, ViewInfo *out);
 static command_result GetMapInfo(color_ostream &stream, const EmptyMessage *in, MapInfo *out);
-static command_result ResetMapHashes(color_ostream &stream, const EmptyMessage *in);
 static command_result GetWorldMap(color_ostream &stream, const EmptyMessage *in, WorldMap *out);
 static command_result GetWorldMapNew(color_ostream &stream, const EmptyMessage *in, WorldMap *out);
 static command_result GetWorldMapCenter(color_ostream &stream, const EmptyMessage *in, WorldMap *out);
@@ -176,6 +176,123 @@ static command_result GetGameValidity(color_ostream &stream, const EmptyMessage
 
 void CopyBlock(df::map_block * DfBlock, RemoteFortressReader::MapBlock * NetBlock, MapExtras::MapCache * MC, DFCoord pos);
 
+// Remembers what GetBlockList has already sent. Every client connection has
+// its own tracker, so several viewers can stream the same map without one of
+// them consuming the changes the others have not seen yet.
+class MapChangeTracker
+{
+public:
+    bool IsTiletypeChanged(df::map_block * block);
+    bool IsDesignationChanged(df::map_block * block);
+    bool IsSpatterChanged(df::map_block * block);
+    bool IsEngravingNew(size_t index);
+    void EngravingIsNotNew(size_t index);
+    void Reset();
+
+private:
+    struct BlockHashes
+    {
+        uint16_t tiletype = 0;
+        uint16_t designation = 0;
+        uint16_t spatter = 0;
+    };
+
+    // indexed by block coordinate; resized whenever the map dimensions change
+    std::vector<BlockHashes> blockHashes;
+    int x_count = 0, y_count = 0, z_count = 0;
+    std::vector<bool> sentEngravings;
+
+    BlockHashes * GetHashes(df::map_block * block);
+};
+
+static command_result GetBlockList(color_ostream &stream, const BlockRequest *in, BlockList *out, MapChangeTracker &tracker);
+
+// Content versions of a map block, shared by all block subscriptions. A block
+// is rehashed at most once per Core update however many clients are watching
+// it, and each version only changes when the corresponding hash does.
+struct BlockVersions
+{
+    uint32_t checked_frame = 0;
+    uint16_t tiletype_hash = 0;
+    uint16_t designation_hash = 0;
+    uint16_t spatter_hash = 0;
+    uint16_t items_hash = 0;
+    uint32_t tiletype = 0;
+    uint32_t designation = 0;
+    uint32_t spatter = 0;
+    uint32_t items = 0;
+    // indices into world->engravings of the engravings in this block
+    std::vector<size_t> engravings;
+};
+
+class BlockVersionCache
+{
+public:
+    // resets the cache if the map dimensions changed; returns the epoch, which
+    // subscribers compare against to notice that old versions are meaningless
+    uint32_t Validate();
+    const BlockVersions * Refresh(df::map_block * block);
+
+private:
+    std::vector<BlockVersions> blocks;
+    int x_count = 0, y_count = 0, z_count = 0;
+    uint32_t epoch = 0;
+
+    // blocks with a non-empty engravings list, and the update and engravings
+    // count they were filled at
+    std::vector<size_t> engraved;
+    uint32_t engravings_frame = 0;
+    size_t engravings_count = 0;
+
+    void BucketEngravings();
+};
+
+class RemoteFortressReaderService : public RPCService
+{
+public:
+    RemoteFortressReaderService();
+
+private:
+    MapChangeTracker tracker;
+
+    // volume registered with SubscribeBlockUpdates, in block coordinates
+    // (max exclusive), and the block versions this client has been sent
+    struct BlockSubscription
+    {
+        struct SentVersions
+        {
+            uint32_t tiletype = 0;
+            uint32_t designation = 0;
+            uint32_t spatter = 0;
+            uint32_t items = 0;
+            bool flows = false;
+        };
+
+        bool active = false;
+        int min_x = 0, min_y = 0, min_z = 0;
+        int max_x = 0, max_y = 0, max_z = 0;
+        int frame_blocks = 0;
+        uint32_t epoch = 0;
+        size_t cursor = 0;
+        std::vector<SentVersions> sent;
+    } subscription;
+
+    command_result SubscribeBlockUpdates(color_ostream &stream, const BlockRequest *in);
+    command_result UnsubscribeBlockUpdates(color_ostream &stream, const EmptyMessage *in);
+    command_result GetBlockUpdates(color_ostream &stream, const EmptyMessage *in, BlockList *out);
+
+    command_result GetBlockList(color_ostream &stream, const BlockRequest *in, BlockList *out)
+    {
+        return ::GetBlockList(stream, in, out, tracker);
+    }
+
+    command_result ResetMapHashes(color_ostream &stream, const EmptyMessage *in)
+    {
+        tracker.Reset();
+        return CR_OK;
+    }
+};
+
 const char* growth_locations[] = {
     "TWIGS",
     "LIGHT_BRANCHES",
@@ -240,31 +357,38 @@ DFhackCExport command_result plugin_init(color_ostream &out, std::vector <Plugin
 #define SF_ALLOW_REMOTE 0
 #endif // !SF_ALLOW_REMOTE
 
+RemoteFortressReaderService::RemoteFortressReaderService()
+{
+    addMethod("GetBlockList", &RemoteFortressReaderService::GetBlockList, SF_ALLOW_REMOTE);
+    addMethod("ResetMapHashes", &RemoteFortressReaderService::ResetMapHashes, SF_ALLOW_REMOTE);
+    addMethod("SubscribeBlockUpdates", &RemoteFortressReaderService::SubscribeBlockUpdates, SF_ALLOW_REMOTE);
+    addMethod("UnsubscribeBlockUpdates", &RemoteFortressReaderService::UnsubscribeBlockUpdates, SF_ALLOW_REMOTE);
+    addMethod("GetBlockUpdates", &RemoteFortressReaderService::GetBlockUpdates, SF_ALLOW_REMOTE);
+}
+
 DFhackCExport RPCService *plugin_rpcconnect(color_ostream &)
 {
-    RPCService *svc = new RPCService();
+    RPCService *svc = new RemoteFortressReaderService();
     svc->addFunction("GetMaterialList", GetMaterialList, SF_ALLOW_REMOTE);
-    svc->addFunction("GetGrowthList", GetGrowthList, SF_ALLOW_REMOTE);
-    svc->addFunction("GetBlockList", GetBlockList, SF_ALLOW_REMOTE);
+    svc->addFunction("GetGrowthList", GetGrowthList, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("CheckHashes", CheckHashes, SF_ALLOW_REMOTE);
-    svc->addFunction("GetTiletypeList", GetTiletypeList, SF_ALLOW_REMOTE);
+    svc->addFunction("GetTiletypeList", GetTiletypeList, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("GetPlantList", GetPlantList, SF_ALLOW_REMOTE);
     svc->addFunction("GetUnitList", GetUnitList, SF_ALLOW_REMOTE);
     svc->addFunction("GetUnitListInside", GetUnitListInside, SF_ALLOW_REMOTE);
     svc->addFunction("GetViewInfo", GetViewInfo, SF_ALLOW_REMOTE);
     svc->addFunction("GetMapInfo", GetMapInfo, SF_ALLOW_REMOTE);
-    svc->addFunction("ResetMapHashes", ResetMapHashes, SF_ALLOW_REMOTE);
     svc->addFunction("GetItemList", GetItemList, SF_ALLOW_REMOTE);
-    svc->addFunction("GetBuildingDefList", GetBuildingDefList, SF_ALLOW_REMOTE);
+    svc->addFunction("GetBuildingDefList", GetBuildingDefList, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("GetWorldMap", GetWorldMap, SF_ALLOW_REMOTE);
     svc->addFunction("GetWorldMapNew", GetWorldMapNew, SF_ALLOW_REMOTE);
     svc->addFunction("GetRegionMaps", GetRegionMaps, SF_ALLOW_REMOTE);
     svc->addFunction("GetRegionMapsNew", GetRegionMapsNew, SF_ALLOW_REMOTE);
-    svc->addFunction("GetCreatureRaws", GetCreatureRaws, SF_ALLOW_REMOTE);
-    svc->addFunction("GetPartialCreatureRaws", GetPartialCreatureRaws, SF_ALLOW_REMOTE);
+    svc->addFunction("GetCreatureRaws", GetCreatureRaws, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
+    svc->addFunction("GetPartialCreatureRaws", GetPartialCreatureRaws, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("GetWorldMapCenter", GetWorldMapCenter, SF_ALLOW_REMOTE);
-    svc->addFunction("GetPlantRaws", GetPlantRaws, SF_ALLOW_REMOTE);
-    svc->addFunction("GetPartialPlantRaws", GetPartialPlantRaws, SF_ALLOW_REMOTE);
+    svc->addFunction("GetPlantRaws", GetPlantRaws, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
+    svc->addFunction("GetPartialPlantRaws", GetPartialPlantRaws, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("CopyScreen", CopyScreen, SF_ALLOW_REMOTE);
     svc->addFunction("PassKeyboardEvent", PassKeyboardEvent, SF_ALLOW_REMOTE);
     svc->addFunction("SendDigCommand", SendDigCommand, SF_ALLOW_REMOTE);
@@ -277,7 +401,7 @@ DFhackCExport RPCService *plugin_rpcconnect(color_ostream &)
     svc->addFunction("MenuQuery", MenuQuery, SF_ALLOW_REMOTE);
     svc->addFunction("MovementSelectCommand", MovementSelectCommand, SF_ALLOW_REMOTE);
     svc->addFunction("MiscMoveCommand", MiscMoveCommand, SF_ALLOW_REMOTE);
-    svc->addFunction("GetLanguage", GetLanguage, SF_ALLOW_REMOTE);
+    svc->addFunction("GetLanguage", GetLanguage, SF_ALLOW_REMOTE | SF_IMMUTABLE_DATA);
     svc->addFunction("GetSideMenu", GetSideMenu, SF_ALLOW_REMOTE);
     svc->addFunction("SetSideMenu", SetSideMenu, SF_ALLOW_REMOTE);
     svc->addFunction("GetGameValidity", GetGameValidity, SF_ALLOW_REMOTE);
@@ -644,66 +768,53 @@ void CopyMat(RemoteFortressReader::MatPair * mat, int type, int index)
 
 }
 
-std::map<DFCoord, uint16_t> hashes;
-
-bool IsTiletypeChanged(DFCoord pos)
+MapChangeTracker::BlockHashes * MapChangeTracker::GetHashes(df::map_block * block)
 {
-    uint16_t hash;
-    df::map_block * block = Maps::getBlock(pos);
-    if (block)
-        hash = fletcher16((uint8_t*)(block->tiletype), 16 * 16 * (sizeof(df::enums::tiletype::tiletype)));
-    else
-        hash = 0;
-    if (hashes[pos] != hash)
+    if (x_count != world->map.x_count_block || y_count != world->map.y_count_block || z_count != world->map.z_count_block)
     {
-        hashes[pos] = hash;
-        return true;
+        x_count = world->map.x_count_block;
+        y_count = world->map.y_count_block;
+        z_count = world->map.z_count_block;
+        blockHashes.assign(size_t(x_count) * y_count * z_count, BlockHashes());
     }
-    return false;
+    int x = block->map_pos.x / 16;
+    int y = block->map_pos.y / 16;
+    int z = block->map_pos.z;
+    if (x < 0 || x >= x_count || y < 0 || y >= y_count || z < 0 || z >= z_count)
+        return NULL;
+    return &blockHashes[(size_t(z) * y_count + y) * x_count + x];
 }
 
-std::map<DFCoord, uint16_t> waterHashes;
-
-bool IsDesignationChanged(DFCoord pos)
+bool MapChangeTracker::IsTiletypeChanged(df::map_block * block)
 {
-    uint16_t hash;
-    df::map_block * block = Maps::getBlock(pos);
-    if (block)
-        hash = fletcher16((uint8_t*)(block->designation), 16 * 16 * (sizeof(df::tile_designation)));
-    else
-        hash = 0;
-    if (waterHashes[pos] != hash)
+    auto hashes = GetHashes(block);
+    if (!hashes)
+        return true;
+    uint16_t hash = fletcher16((uint8_t*)(block->tiletype), 16 * 16 * (sizeof(df::enums::tiletype::tiletype)));
+    if (hashes->tiletype != hash)
     {
-        waterHashes[pos] = hash;
+        hashes->tiletype = hash;
         return true;
     }
     return false;
 }
 
-std::map<DFCoord, uint8_t> buildingHashes;
-
-bool IsBuildingChanged(DFCoord pos)
+bool MapChangeTracker::IsDesignationChanged(df::map_block * block)
 {
-    df::map_block * block = Maps::getBlock(pos);
-    bool changed = false;
-    for (int x = 0; x < 16; x++)
-        for (int y = 0; y < 16; y++)
-        {
-            auto bld = block->occupancy[x][y].bits.building;
-            if (buildingHashes[pos] != bld)
-            {
-                buildingHashes[pos] = bld;
-                changed = true;
-            }
-        }
-    return changed;
+    auto hashes = GetHashes(block);
+    if (!hashes)
+        return true;
+    uint16_t hash = fletcher16((uint8_t*)(block->designation), 16 * 16 * (sizeof(df::tile_designation)));
+    if (hashes->designation != hash)
+    {
+        hashes->designation = hash;
+        return true;
+    }
+    return false;
 }
 
-std::map<DFCoord, uint16_t> spatterHashes;
-
-bool IsspatterChanged(DFCoord pos)
+static bool GetSpatterHash(df::map_block * block, uint16_t &hash)
 {
-    df::map_block * block = Maps::getBlock(pos);
     std::vector<df::block_square_event_material_spatterst *> materials;
 #if DF_VERSION_INT > 34011
     std::vector<df::block_square_event_item_spatterst *> items;
@@ -714,7 +825,7 @@ bool IsspatterChanged(DFCoord pos)
         return false;
 #endif
 
-    uint16_t hash = 0;
+    hash = 0;
 
     for (size_t i = 0; i < materials.size(); i++)
     {
@@ -728,67 +839,156 @@ bool IsspatterChanged(DFCoord pos)
         hash ^= fletcher16((uint8_t*)item, sizeof(df::block_square_event_item_spatterst));
     }
 #endif
-    if (spatterHashes[pos] != hash)
-    {
-        spatterHashes[pos] = hash;
-        return true;
-    }
-    return false;
+    return true;
 }
 
-std::map<int, uint16_t> itemHashes;
-
-bool isItemChanged(int i)
+// covers the ids and positions of the items in the block
+static uint16_t GetItemsHash(df::map_block * block)
 {
-    uint16_t hash = 0;
-    auto item = df::item::find(i);
-    if (item)
+    std::vector<int32_t> data;
+    data.reserve(block->items.size() * 4);
+    for (auto id : block->items)
     {
-        hash = fletcher16((uint8_t*)item, sizeof(df::item));
+        auto item = df::item::find(id);
+        if (!item)
+            continue;
+        data.push_back(id);
+        data.push_back(item->pos.x);
+        data.push_back(item->pos.y);
+        data.push_back(item->pos.z);
     }
-    if (itemHashes[i] != hash)
+    if (data.empty())
+        return 0;
+    return fletcher16((uint8_t*)data.data(), data.size() * sizeof(int32_t));
+}
+
+bool MapChangeTracker::IsSpatterChanged(df::map_block * block)
+{
+    uint16_t hash;
+    if (!GetSpatterHash(block, hash))
+        return false;
+
+    auto hashes = GetHashes(block);
+    if (!hashes)
+        return true;
+
+    if (hashes->spatter != hash)
     {
-        itemHashes[i] = hash;
+        hashes->spatter = hash;
         return true;
     }
     return false;
 }
 
-bool areItemsChanged(std::vector<int> * items)
+bool MapChangeTracker::IsEngravingNew(size_t index)
 {
-    bool result = false;
-    for (size_t i = 0; i < items->size(); i++)
-    {
-        if (isItemChanged(items->at(i)))
-            result = true;
-    }
-    return result;
+    if (index >= sentEngravings.size())
+        sentEngravings.resize(index + 1, false);
+    if (sentEngravings[index])
+        return false;
+    sentEngravings[index] = true;
+    return true;
 }
 
-std::map<int, int> engravingHashes;
+void MapChangeTracker::EngravingIsNotNew(size_t index)
+{
+    if (index < sentEngravings.size())
+        sentEngravings[index] = false;
+}
 
-bool isEngravingNew(int index)
+void MapChangeTracker::Reset()
 {
-    if (engravingHashes[index])
-        return false;
-    engravingHashes[index] = true;
-    return true;
+    blockHashes.clear();
+    x_count = y_count = z_count = 0;
+    sentEngravings.clear();
 }
 
-void engravingIsNotNew(int index)
+static BlockVersionCache blockVersions;
+
+uint32_t BlockVersionCache::Validate()
 {
-    engravingHashes[index] = false;
+    if (x_count != world->map.x_count_block || y_count != world->map.y_count_block || z_count != world->map.z_count_block)
+    {
+        x_count = world->map.x_count_block;
+        y_count = world->map.y_count_block;
+        z_count = world->map.z_count_block;
+        blocks.assign(size_t(x_count) * y_count * z_count, BlockVersions());
+        engraved.clear();
+        engravings_frame = 0;
+        epoch++;
+    }
+    return epoch;
 }
 
-static command_result ResetMapHashes(color_ostream &stream, const EmptyMessage *in)
+void BlockVersionCache::BucketEngravings()
 {
-    hashes.clear();
-    waterHashes.clear();
-    buildingHashes.clear();
-    spatterHashes.clear();
-    itemHashes.clear();
-    engravingHashes.clear();
-    return CR_OK;
+    for (size_t idx : engraved)
+        blocks[idx].engravings.clear();
+    engraved.clear();
+    engravings_count = world->engravings.size();
+
+    for (size_t i = 0; i < engravings_count; i++)
+    {
+        auto &pos = world->engravings[i]->pos;
+        int x = pos.x / 16;
+        int y = pos.y / 16;
+        int z = pos.z;
+        if (pos.x < 0 || x >= x_count || pos.y < 0 || y >= y_count || z < 0 || z >= z_count)
+            continue;
+        size_t idx = (size_t(z) * y_count + y) * x_count + x;
+        if (blocks[idx].engravings.empty())
+            engraved.push_back(idx);
+        blocks[idx].engravings.push_back(i);
+    }
+}
+
+const BlockVersions * BlockVersionCache::Refresh(df::map_block * block)
+{
+    int x = block->map_pos.x / 16;
+    int y = block->map_pos.y / 16;
+    int z = block->map_pos.z;
+    if (x < 0 || x >= x_count || y < 0 || y >= y_count || z < 0 || z >= z_count)
+        return NULL;
+
+    // the Core counter advances even while this plugin is disabled
+    uint32_t frame = Core::getInstance().getUpdateCount();
+    if (engravings_frame != frame || engravings_count != world->engravings.size())
+    {
+        engravings_frame = frame;
+        BucketEngravings();
+    }
+
+    auto &entry = blocks[(size_t(z) * y_count + y) * x_count + x];
+    if (entry.checked_frame == frame)
+        return &entry;
+
+    bool first = entry.checked_frame == 0;
+    entry.checked_frame = frame;
+
+    uint16_t hash = fletcher16((uint8_t*)(block->tiletype), 16 * 16 * (sizeof(df::enums::tiletype::tiletype)));
+    if (first || entry.tiletype_hash != hash)
+    {
+        entry.tiletype_hash = hash;
+        entry.tiletype++;
+    }
+    hash = fletcher16((uint8_t*)(block->designation), 16 * 16 * (sizeof(df::tile_designation)));
+    if (first || entry.designation_hash != hash)
+    {
+        entry.designation_hash = hash;
+        entry.designation++;
+    }
+    if (GetSpatterHash(block, hash) && (first || entry.spatter_hash != hash))
+    {
+        entry.spatter_hash = hash;
+        entry.spatter++;
+    }
+    hash = GetItemsHash(block);
+    if (first || entry.items_hash != hash)
+    {
+        entry.items_hash = hash;
+        entry.items++;
+    }
+    return &entry;
 }
 
 df::matter_state GetState(df::material * mat, uint16_t temp = 10015)
@@ -1369,7 +1569,88 @@ void CopyFlows(df::map_block * DfBlock, RemoteFortressReader::MapBlock * NetBloc
     }
 }
 
-static command_result GetBlockList(color_ostream &stream, const BlockRequest *in, BlockList *out)
+// true if the block has nothing a viewer would draw: only open space, with no
+// liquid, buildings or flows
+static bool IsAirBlock(df::map_block * block)
+{
+    if (block->flows.size() > 0)
+        return false;
+    for (int xxx = 0; xxx < 16; xxx++)
+        for (int yyy = 0; yyy < 16; yyy++)
+        {
+            if ((DFHack::tileShapeBasic(DFHack::tileShape(block->tiletype[xxx][yyy])) != df::tiletype_shape_basic::None &&
+                DFHack::tileShapeBasic(DFHack::tileShape(block->tiletype[xxx][yyy])) != df::tiletype_shape_basic::Open)
+                || block->designation[xxx][yyy].bits.flow_size > 0
+                || block->occupancy[xxx][yyy].bits.building > 0)
+                return false;
+        }
+    return true;
+}
+
+// adds the engraving at the given index into world->engravings unless this
+// client has been sent it already
+static void CopyEngraving(BlockList *out, MapChangeTracker &tracker, size_t index)
+{
+    if (!tracker.IsEngravingNew(index))
+        return;
+
+    auto engraving = world->engravings[index];
+    df::art_image_chunk * chunk = NULL;
+    GET_ART_IMAGE_CHUNK GetArtImageChunk = reinterpret_cast<GET_ART_IMAGE_CHUNK>(Core::getInstance().vinfo->getAddress("get_art_image_chunk"));
+    if (GetArtImageChunk)
+    {
+        chunk = GetArtImageChunk(&(world->art_image_chunks), engraving->art_id);
+    }
+    else
+    {
+        for (size_t i = 0; i < world->art_image_chunks.size(); i++)
+        {
+            if (world->art_image_chunks[i]->id == engraving->art_id)
+                chunk = world->art_image_chunks[i];
+        }
+    }
+    if (!chunk)
+    {
+        tracker.EngravingIsNotNew(index);
+        return;
+    }
+    auto netEngraving = out->add_engravings();
+    ConvertDFCoord(engraving->pos, netEngraving->mutable_pos());
+    netEngraving->set_quality(engraving->quality);
+    netEngraving->set_tile(engraving->tile);
+    if (chunk->images[engraving->art_subid]) {
+        CopyImage(chunk->images[engraving->art_subid], netEngraving->mutable_image());
+    }
+    netEngraving->set_floor(engraving->flags.bits.floor);
+    netEngraving->set_west(engraving->flags.bits.west);
+    netEngraving->set_east(engraving->flags.bits.east);
+    netEngraving->set_north(engraving->flags.bits.north);
+    netEngraving->set_south(engraving->flags.bits.south);
+    netEngraving->set_hidden(engraving->flags.bits.hidden);
+    netEngraving->set_northwest(engraving->flags.bits.northwest);
+    netEngraving->set_northeast(engraving->flags.bits.northeast);
+    netEngraving->set_southwest(engraving->flags.bits.southwest);
+    netEngraving->set_southeast(engraving->flags.bits.southeast);
+}
+
+// adds the engravings in the given block volume that this client has not
+// been sent yet
+static void CopyEngravings(BlockList *out, MapChangeTracker &tracker, int min_x, int min_y, int min_z, int max_x, int max_y, int max_z)
+{
+    for (size_t i = 0; i < world->engravings.size(); i++)
+    {
+        auto engraving = world->engravings[i];
+        if (engraving->pos.x < (min_x * 16) || engraving->pos.x >(max_x * 16))
+            continue;
+        if (engraving->pos.y < (min_y * 16) || engraving->pos.y >(max_y * 16))
+            continue;
+        if (engraving->pos.z < min_z || engraving->pos.z > max_z)
+            continue;
+        CopyEngraving(out, tracker, i);
+    }
+}
+
+static command_result GetBlockList(color_ostream &stream, const BlockRequest *in, BlockList *out, MapChangeTracker &tracker)
 {
     int x, y, z;
     DFHack::Maps::getPosition(x, y, z);
@@ -1416,27 +1697,12 @@ static command_result GetBlockList(color_ostream &stream, const BlockRequest *in
                 df::map_block * block = DFHack::Maps::getBlock(pos);
                 if (block != NULL)
                 {
-                    bool nonAir = false;
-                    for (int xxx = 0; xxx < 16; xxx++)
-                        for (int yyy = 0; yyy < 16; yyy++)
-                        {
-                            if ((DFHack::tileShapeBasic(DFHack::tileShape(block->tiletype[xxx][yyy])) != df::tiletype_shape_basic::None &&
-                                DFHack::tileShapeBasic(DFHack::tileShape(block->tiletype[xxx][yyy])) != df::tiletype_shape_basic::Open)
-                                || block->designation[xxx][yyy].bits.flow_size > 0
-                                || block->occupancy[xxx][yyy].bits.building > 0)
-                            {
-                                nonAir = true;
-                                goto ItsAir;
-                            }
-                        }
-                ItsAir:
-                    if (block->flows.size() > 0)
-                        nonAir = true;
+                    bool nonAir = !IsAirBlock(block);
                     if (nonAir || firstBlock)
                     {
-                        bool tileChanged = IsTiletypeChanged(pos);
-                        bool desChanged = IsDesignationChanged(pos);
-                        bool spatterChanged = IsspatterChanged(pos);
+                        bool tileChanged = tracker.IsTiletypeChanged(block);
+                        bool desChanged = tracker.IsDesignationChanged(block);
+                        bool spatterChanged = tracker.IsSpatterChanged(block);
                         bool itemsChanged = block->items.size() > 0;
                         bool flows = block->flows.size() > 0;
                         RemoteFortressReader::MapBlock *net_block = nullptr;
@@ -1496,55 +1762,7 @@ static command_result GetBlockList(color_ostream &stream, const BlockRequest *in
         }
     }
 
-    for (size_t i = 0; i < world->engravings.size(); i++)
-    {
-        auto engraving = world->engravings[i];
-        if (engraving->pos.x < (min_x * 16) || engraving->pos.x >(max_x * 16))
-            continue;
-        if (engraving->pos.y < (min_y * 16) || engraving->pos.y >(max_y * 16))
-            continue;
-        if (engraving->pos.z < min_z || engraving->pos.z > max_z)
-            continue;
-        if (!isEngravingNew(i))
-            continue;
-
-        df::art_image_chunk * chunk = NULL;
-        GET_ART_IMAGE_CHUNK GetArtImageChunk = reinterpret_cast<GET_ART_IMAGE_CHUNK>(Core::getInstance().vinfo->getAddress("get_art_image_chunk"));
-        if (GetArtImageChunk)
-        {
-            chunk = GetArtImageChunk(&(world->art_image_chunks), engraving->art_id);
-        }
-        else
-        {
-            for (size_t i = 0; i < world->art_image_chunks.size(); i++)
-            {
-                if (world->art_image_chunks[i]->id == engraving->art_id)
-                    chunk = world->art_image_chunks[i];
-            }
-        }
-        if (!chunk)
-        {
-            engravingIsNotNew(i);
-            continue;
-        }
-        auto netEngraving = out->add_engravings();
-        ConvertDFCoord(engraving->pos, netEngraving->mutable_pos());
-        netEngraving->set_quality(engraving->quality);
-        netEngraving->set_tile(engraving->tile);
-        if (chunk->images[engraving->art_subid]) {
-            CopyImage(chunk->images[engraving->art_subid], netEngraving->mutable_image());
-        }
-        netEngraving->set_floor(engraving->flags.bits.floor);
-        netEngraving->set_west(engraving->flags.bits.west);
-        netEngraving->set_east(engraving->flags.bits.east);
-        netEngraving->set_north(engraving->flags.bits.north);
-        netEngraving->set_south(engraving->flags.bits.south);
-        netEngraving->set_hidden(engraving->flags.bits.hidden);
-        netEngraving->set_northwest(engraving->flags.bits.northwest);
-        netEngraving->set_northeast(engraving->flags.bits.northeast);
-        netEngraving->set_southwest(engraving->flags.bits.southwest);
-        netEngraving->set_southeast(engraving->flags.bits.southeast);
-    }
+    CopyEngravings(out, tracker, min_x, min_y, min_z, max_x, max_y, max_z);
     for (size_t i = 0; i < world->ocean_waves.size(); i++)
     {
         auto wave = world->ocean_waves[i];
@@ -1556,6 +1774,141 @@ static command_result GetBlockList(color_ostream &stream, const BlockRequest *in
     return CR_OK;
 }
 
+static const int DEFAULT_UPDATE_FRAME_BLOCKS = 256;
+
+command_result RemoteFortressReaderService::SubscribeBlockUpdates(color_ostream &stream, const BlockRequest *in)
+{
+    if (!Maps::IsValid())
+    {
+        stream.printerr("Map is not available.\n");
+        return CR_FAILURE;
+    }
+
+    auto &sub = subscription;
+    sub.min_x = std::max(0, in->min_x());
+    sub.min_y = std::max(0, in->min_y());
+    sub.min_z = std::max(0, in->min_z());
+    sub.max_x = std::min(int(world->map.x_count_block), in->max_x());
+    sub.max_y = std::min(int(world->map.y_count_block), in->max_y());
+    sub.max_z = std::min(int(world->map.z_count_block), in->max_z());
+    if (sub.min_x >= sub.max_x || sub.min_y >= sub.max_y || sub.min_z >= sub.max_z)
+    {
+        stream.printerr("Empty block subscription volume.\n");
+        sub.active = false;
+        return CR_WRONG_USAGE;
+    }
+
+    sub.frame_blocks = in->blocks_needed() > 0 ? in->blocks_needed() : DEFAULT_UPDATE_FRAME_BLOCKS;
+    sub.epoch = blockVersions.Validate();
+    sub.cursor = 0;
+    sub.sent.assign(size_t(sub.max_x - sub.min_x) * (sub.max_y - sub.min_y) * (sub.max_z - sub.min_z),
+                    BlockSubscription::SentVersions());
+    sub.active = true;
+    return CR_OK;
+}
+
+command_result RemoteFortressReaderService::UnsubscribeBlockUpdates(color_ostream &stream, const EmptyMessage *in)
+{
+    subscription.active = false;
+    subscription.sent.clear();
+    return CR_OK;
+}
+
+// Returns the next frame of changed blocks in the subscribed volume: at most
+// frame_blocks of them, resuming where the previous frame stopped so that a
+// busy area cannot starve the rest of the volume. Tiles, designations and
+// spatters are only included when they changed; items and flows are always
+// complete, as in GetBlockList. Engravings the client has not been sent yet
+// are added as the walk reaches their block.
+command_result RemoteFortressReaderService::GetBlockUpdates(color_ostream &stream, const EmptyMessage *in, BlockList *out)
+{
+    auto &sub = subscription;
+    if (!sub.active)
+    {
+        stream.printerr("No block subscription.\n");
+        return CR_WRONG_USAGE;
+    }
+    if (!Maps::IsValid())
+        return CR_FAILURE;
+
+    uint32_t epoch = blockVersions.Validate();
+    if (epoch != sub.epoch)
+    {
+        // the map changed under the subscription; start over
+        sub.epoch = epoch;
+        sub.sent.assign(sub.sent.size(), BlockSubscription::SentVersions());
+    }
+
+    int x, y, z;
+    DFHack::Maps::getPosition(x, y, z);
+    out->set_map_x(x);
+    out->set_map_y(y);
+
+    std::unique_ptr<MapExtras::MapCache> MC;
+    size_t width = sub.max_x - sub.min_x;
+    size_t height = sub.max_y - sub.min_y;
+    size_t volume = sub.sent.size();
+    int blocks_sent = 0;
+    for (size_t n = 0; n < volume && blocks_sent < sub.frame_blocks; n++)
+    {
+        size_t idx = sub.cursor;
+        sub.cursor = (sub.cursor + 1) % volume;
+
+        DFCoord pos(sub.min_x + idx % width, sub.min_y + (idx / width) % height, sub.min_z + idx / (width * height));
+        df::map_block * block = DFHack::Maps::getBlock(pos);
+        if (!block)
+            continue;
+        auto versions = blockVersions.Refresh(block);
+        if (!versions)
+            continue;
+        for (size_t i : versions->engravings)
+            CopyEngraving(out, tracker, i);
+
+        auto &sent = sub.sent[idx];
+        bool flows = block->flows.size() > 0;
+        bool tileChanged = sent.tiletype != versions->tiletype;
+        bool desChanged = sent.designation != versions->designation;
+        bool spatterChanged = sent.spatter != versions->spatter;
+        bool itemsChanged = sent.items != versions->items;
+        if (!tileChanged && !desChanged && !spatterChanged && !itemsChanged && !flows && !sent.flows)
+            continue;
+
+        // don't bother clients with empty sky they have never seen
+        bool skip = !sent.tiletype && IsAirBlock(block);
+
+        sent.tiletype = versions->tiletype;
+        sent.designation = versions->designation;
+        sent.spatter = versions->spatter;
+        sent.items = versions->items;
+        sent.flows = flows;
+        if (skip)
+            continue;
+
+        if (!MC)
+            MC.reset(new MapExtras::MapCache());
+
+        auto net_block = out->add_map_blocks();
+        net_block->set_map_x(block->map_pos.x);
+        net_block->set_map_y(block->map_pos.y);
+        net_block->set_map_z(block->map_pos.z);
+        if (tileChanged)
+            CopyBlock(block, net_block, MC.get(), pos);
+        if (desChanged)
+            CopyDesignation(block, net_block, MC.get(), pos);
+        if (spatterChanged)
+            Copyspatters(block, net_block, MC.get(), pos);
+        if (block->items.size() > 0)
+            CopyItems(block, net_block, MC.get(), pos);
+        if (flows)
+            CopyFlows(block, net_block);
+        blocks_sent++;
+    }
+
+    if (MC)
+        MC->trash();
+    return CR_OK;
+}
+
 static command_result GetTiletypeList(color_ostream &stream, const EmptyMessage *in, TiletypeList *out)
 {
     int count = 0;
@@ -7,7 +7,9 @@
 #include "LuaTools.h"
 #include "PluginManager.h"
 
+#include "modules/Clothing.h"
 #include "modules/Materials.h"
+#include "modules/Orders.h"
 #include "modules/Persistence.h"
 #include "modules/Translation.h"
 #include "modules/Units.h"
@@ -108,22 +110,6 @@ static const std::list<MatType> all_materials = { M_SILK, M_CLOTH, M_YARN, M_LEA
 static const std::list<MatType> default_materials = { M_SILK, M_CLOTH, M_YARN, M_LEATHER }; // adamantine not included by default
 static std::list<MatType> material_order = default_materials;
 
-static struct BadFlags {
-    uint32_t whole;
-
-    BadFlags() {
-        df::item_flags flags;
-        #define F(x) flags.bits.x = true;
-        F(dump); F(forbid); F(garbage_collect);
-        F(hostile); F(on_fire); F(rotten); F(trader);
-        F(in_building); F(construction); F(owned);
-        F(in_chest); F(removed); F(encased);
-        F(spider_web);
-        #undef F
-        whole = flags.whole;
-    }
-} badFlags;
-
 class Tailor {
 
 private:
@@ -159,21 +145,17 @@ public:
 
     void scan_clothing()
     {
-        for (auto i : world->items.other[df::items_other_id::ANY_GENERIC37]) // GENERIC37 is "nontattered clothing"
+        // only unowned, untattered items that nothing else has a claim on count
+        for (auto& [slot, counts] : Clothing::getLedger().unowned)
         {
-            if (i->flags.whole & badFlags.whole)
-            {
-                continue;
-            }
-            if (i->getWear() >= 1)
+            if (!slot.clothing || !counts.available)
                 continue;
-            if (i->getMakerRace() < 0) // sometimes we get borked items with no valid maker race
+            if (slot.race < 0) // sometimes we get borked items with no valid maker race
                 continue;
 
-            df::item_type t = i->getType();
-            int size = world->raws.creatures.all[i->getMakerRace()]->adultsize;
+            int size = world->raws.creatures.all[slot.race]->adultsize;
 
-            available[std::make_pair(t, size)] += 1;
+            available[std::make_pair(slot.type, size)] += counts.available;
         }
 
         if (DBG_NAME(cycle).isEnabled(DebugCategory::LDEBUG))
@@ -192,10 +174,11 @@ public:
     void scan_materials()
     {
         bool require_dyed = df::global::standing_orders_use_dyed_cloth ? (*df::global::standing_orders_use_dyed_cloth) : false;
+        const uint32_t badFlags = Clothing::getUnavailableFlags();
 
         for (auto i : world->items.other[df::items_other_id::CLOTH])
         {
-            if (i->flags.whole & badFlags.whole)
+            if (i->flags.whole & badFlags)
                 continue;
 
             if (require_dyed && (!i->isDyed()))
@@ -230,7 +213,7 @@ public:
 
         for (auto i : world->items.other[df::items_other_id::SKIN_TANNED])
         {
-            if (i->flags.whole & badFlags.whole)
+            if (i->flags.whole & badFlags)
                 continue;
             supply[M_LEATHER] += i->getStackSize();
         }
@@ -428,14 +411,13 @@ public:
     }
 
     static df::manager_order * get_existing_order(df::job_type ty, int16_t sub, int32_t hfid, df::job_material_category mcat) {
-        for (auto order : world->manager_orders) {
-            if (order->job_type == ty &&
-                    order->item_type == df::item_type::NONE &&
-                    order->item_subtype == sub &&
-                    order->mat_type == -1 &&
-                    order->mat_index == -1 &&
-                    order->hist_figure_id == hfid &&
-                    order->material_category.whole == mcat.whole &&
+        Orders::OrderSpec spec;
+        spec.job_type = ty;
+        spec.item_subtype = sub;
+        spec.hist_figure_id = hfid;
+        spec.material_category = mcat.whole;
+        for (auto order : Orders::getOrders(ty, sub)) {
+            if (spec.matches(order) &&
                     order->frequency == df::manager_order::T_frequency::OneTime)
                 return order;
         }
@@ -554,7 +536,7 @@ public:
                             order->hist_figure_id = sizes[size];
                             order->material_category = m.job_material;
 
-                            world->manager_orders.push_back(order);
+                            Orders::addOrder(order);
                         }
 
                         INFO(cycle).print("tailor: added order #%d for %d %s %s, sized for %s\n",
@@ -878,35 +878,15 @@ static df::building* getAssignableBuildingAtCursor(color_ostream& out)
 
 // ZONE FILTERS (as in, filters used by 'zone')
 
-// Maps parameter names to filters.
+// Filters that only make sense for zone; everything else is one of the
+// named filters of Units::UnitQuery.
 static unordered_map<string, function<bool(df::unit*)>> zone_filters;
 static struct zone_filters_init { zone_filters_init() {
-    zone_filters["caged"] = isContainedInItem;
-    zone_filters["egglayer"] = Units::isEggLayer;
-    zone_filters["female"] = Units::isFemale;
-    zone_filters["grazer"] = Units::isGrazer;
-    zone_filters["hunting"] = Units::isHunter;
-    zone_filters["male"] = Units::isMale;
-    zone_filters["milkable"] = Units::isMilkable;
-    zone_filters["naked"] = Units::isNaked;
-    zone_filters["own"] = Units::isOwnCiv;
-    zone_filters["tamable"] = Units::isTamable;
-    zone_filters["tame"] = Units::isTame;
-    zone_filters["trainablewar"] = [](df::unit *unit) -> bool
-    {
-        return !Units::isWar(unit) && !Units::isHunter(unit) && Units::isTrainableWar(unit);
-    };
-    zone_filters["trainablehunt"] = [](df::unit *unit) -> bool
-    {
-        return !Units::isWar(unit) && !Units::isHunter(unit) && Units::isTrainableHunting(unit);
-    };
-    zone_filters["trained"] = Units::isTrained;
     // backwards compatibility
     zone_filters["unassigned"] = [](df::unit *unit) -> bool
     {
         return !isAssigned(unit);
     };
-    zone_filters["war"] = Units::isWar;
 }} zone_filters_init_;
 
 // Extra annotations / descriptions for parameter names.
@@ -921,110 +901,68 @@ static struct zone_filter_notes_init { zone_filter_notes_init() {
     zone_filter_notes["war"] = "trained war creature";
 }} zone_filter_notes_init_;
 
-static pair<string, function<bool(df::unit*)>> createRaceFilter(vector<string> &filter_args)
+static string createRaceFilter(Units::UnitQuery &query, vector<string> &filter_args, bool negate)
 {
     // guaranteed to exist.
     string race = filter_args[0];
 
-    return make_pair(
-        "race of " + race,
-        [race](df::unit *unit) -> bool {
-            return Units::getRaceName(unit) == race;
-        }
-    );
+    query.race(race, negate);
+    return "race of " + race;
 }
 
-static pair<string, function<bool(df::unit*)>> createAgeFilter(vector<string> &filter_args)
+static double parseAge(const string &arg, const char *what)
 {
-    int target_age;
-    stringstream ss(filter_args[0]);
+    double age;
+    stringstream ss(arg);
 
-    ss >> target_age;
+    ss >> age;
 
     if (ss.fail()) {
         ostringstream err;
-        err <<  "Invalid age: " << filter_args[0] << "; age must be a number!";
+        err <<  "Invalid " << what << ": " << arg << "; age must be a number!";
         throw runtime_error(err.str());
     }
-    if (target_age < 0) {
+    if (age < 0) {
         ostringstream err;
-        err <<  "Invalid age: " << target_age << "; age must be >= 0!";
+        err <<  "Invalid " << what << ": " << age << "; age must be >= 0!";
         throw runtime_error(err.str());
     }
-
-    return make_pair(
-        "age of exactly " + int_to_string(target_age),
-        [target_age](df::unit *unit) -> bool {
-            return Units::getAge(unit, true) == target_age;
-        }
-    );
+    return age;
 }
 
-static pair<string, function<bool(df::unit*)>> createMinAgeFilter(vector<string> &filter_args)
+static string createAgeFilter(Units::UnitQuery &query, vector<string> &filter_args, bool negate)
 {
-    double min_age;
-    stringstream ss(filter_args[0]);
-
-    ss >> min_age;
+    int target_age = int(parseAge(filter_args[0], "age"));
 
-    if (ss.fail()) {
-        ostringstream err;
-        err <<  "Invalid minimum age: " << filter_args[0] << "; age must be a number!";
-        throw runtime_error(err.str());
-    }
-    if (min_age < 0) {
-        ostringstream err;
-        err <<  "Invalid minimum age: " << min_age << "; age must be >= 0!";
-        throw runtime_error(err.str());
-    }
-
-    return make_pair(
-        "minimum age of " + int_to_string(min_age),
-        [min_age](df::unit *unit) -> bool {
-            return Units::getAge(unit, true) >= min_age;
-        }
-    );
+    query.age(target_age, negate);
+    return "age of exactly " + int_to_string(target_age);
 }
 
-static pair<string, function<bool(df::unit*)>> createMaxAgeFilter(vector<string> &filter_args)
+static string createMinAgeFilter(Units::UnitQuery &query, vector<string> &filter_args, bool negate)
 {
-    double max_age;
-    stringstream ss(filter_args[0]);
+    double min_age = parseAge(filter_args[0], "minimum age");
 
-    ss >> max_age;
+    query.minAge(min_age, negate);
+    return "minimum age of " + int_to_string(min_age);
+}
 
-    if (ss.fail()) {
-        ostringstream err;
-        err <<  "Invalid maximum age: " << filter_args[0] << "; age must be a number!";
-        throw runtime_error(err.str());
-    }
-    if (max_age < 0) {
-        ostringstream err;
-        err <<  "Invalid maximum age: " << max_age << "; age must be >= 0!";
-        throw runtime_error(err.str());
-    }
+static string createMaxAgeFilter(Units::UnitQuery &query, vector<string> &filter_args, bool negate)
+{
+    double max_age = parseAge(filter_args[0], "maximum age");
 
-    return make_pair(
-        "maximum age of " + int_to_string(max_age),
-        [max_age](df::unit *unit) -> bool {
-            return Units::getAge(unit, true) <= max_age;
-        }
-    );
+    query.maxAge(max_age, negate);
+    return "maximum age of " + int_to_string(max_age);
 }
 
 // Filters that take arguments.
-// Wow, what a type signature.
-// Applied to their number of arguments in a vector<string>& to create a pair.
+// Maps each name to its number of arguments and a function that adds the
+// filter (inverted if requested) to a query and returns its description.
 // Like:
 //     int argcount = zone_param_filters[...].first;
-//     function<bool(df::unit*)> filter = zone_param_filters[...].second(filter_args);
-// (description, filter).
-// Sort of like filter function constructors.
-// Constructor functions are permitted to throw strings, which will be caught and printed.
-// Result filter functions are not permitted to throw std::exceptions.
-// Result filter functions should not store references
+//     string desc = zone_param_filters[...].second(query, filter_args, negate);
+// The functions are permitted to throw std::runtime_error on bad arguments.
 static unordered_map<string, pair<int,
-           function<pair<string, function<bool(df::unit*)>>(vector<string>&)>>> zone_param_filters;
+           function<string(Units::UnitQuery&, vector<string>&, bool)>>> zone_param_filters;
 static struct zone_param_filters_init { zone_param_filters_init() {
     zone_param_filters["race"] = make_pair(1, createRaceFilter);
     zone_param_filters["age"] = make_pair(1, createAgeFilter);
@@ -1288,10 +1226,11 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
     bool named_filter_set = false;
     bool race_filter_set = false;
 
-    // a vector of active filters
-    // if all filters return true, we process a unit
-    // if any filter returns false, we skip that unit
-    vector<function<bool(df::unit*)>> active_filters;
+    // the active filters; we process a unit only if it passes all of them
+    Units::UnitQuery query;
+    // ignore inactive and undead units
+    query.add(Units::isActive, Units::UnitQuery::CHEAP);
+    query.add([](df::unit *unit) { return Units::isUndead(unit); }, Units::UnitQuery::CHEAP, true);
 
     for (size_t i = start_index; i < parameters.size(); i++)
     {
@@ -1368,77 +1307,6 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
 
             target_count = INT_MAX;
         }
-        else if (zone_filters.count(p) == 1) {
-            string& desc = zone_filter_notes.count(p) == 1 ?
-                zone_filter_notes[p] : p;
-
-            if (invert_filter) {
-                auto &filter = zone_filters[p];
-
-                auto z = not1(filter);
-
-                // we have to invert the filter, so we use a closure
-                active_filters.push_back(not1(filter));
-
-                out.color(COLOR_GREEN);
-                out << "Filter: 'not " << desc << "'"
-                    << endl;
-                out.reset_color();
-
-            } else {
-                active_filters.push_back(zone_filters[p]);
-                out.color(COLOR_GREEN);
-                out << "Filter: '" << desc << "'"
-                    << endl;
-                out.reset_color();
-
-            }
-
-            invert_filter = false;
-        } else if (zone_param_filters.count(p) == 1) {
-            // get the constructor
-            auto &filter_pair = zone_param_filters[p];
-            auto arg_count = filter_pair.first;
-            auto &filter_constructor = filter_pair.second;
-            vector<string> args;
-
-            // get arguments
-            while (arg_count) {
-                i++;
-                arg_count--;
-                args.push_back(parameters[i]);
-            }
-
-            // get results
-            try {
-                auto result_pair = filter_constructor(args);
-                string& desc = result_pair.first;
-                auto& filter = result_pair.second;
-
-                if (invert_filter) {
-                    active_filters.push_back(not1(filter));
-                    out.color(COLOR_GREEN);
-                    out << "Filter: 'not " << desc << "'"
-                        << endl;
-                    out.reset_color();
-
-                } else {
-                    active_filters.push_back(filter);
-                    out.color(COLOR_GREEN);
-                    out << "Filter: '" << desc << "'"
-                        << endl;
-                    out.reset_color();
-
-                }
-                invert_filter = false;
-
-                if (p == "race") {
-                    race_filter_set = true;
-                }
-            } catch (const exception&) {
-                return CR_FAILURE;
-            }
-        }
         else if(p == "merchant")
         {
             if (invert_filter) {
@@ -1446,21 +1314,13 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
                 out << "Filter: 'not merchant'" << endl;
                 out.reset_color();
 
-                active_filters.push_back([](df::unit *unit)
-                    {
-                        return !Units::isMerchant(unit) && !Units::isForest(unit);
-                    }
-                );
+                query.addNamed("merchant", true);
             } else {
                 out.color(COLOR_GREEN);
                 out << "Filter: 'merchant'" << endl;
                 out.reset_color();
 
-                active_filters.push_back([](df::unit *unit)
-                    {
-                        return Units::isMerchant(unit) || Units::isForest(unit);
-                    }
-                );
+                query.addNamed("merchant");
             }
             merchant_filter_set = true;
             invert_filter = false;
@@ -1479,11 +1339,7 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
                     out.reset_color();
 
                 }
-                active_filters.push_back([](df::unit *unit)
-                    {
-                        return !unit->name.has_name;
-                    }
-                );
+                query.addNamed("named", true);
             }
             else
             {
@@ -1491,14 +1347,57 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
                 out << "Filter: 'named'" << endl;
                 out.reset_color();
 
-                active_filters.push_back([](df::unit *unit)
-                    {
-                        return unit->name.has_name;
-                    }
-                );
+                query.addNamed("named");
             }
             named_filter_set = true;
             invert_filter = false;
+        }
+        else if (zone_filters.count(p) == 1 || Units::UnitQuery::hasFilter(p)) {
+            string& desc = zone_filter_notes.count(p) == 1 ?
+                zone_filter_notes[p] : p;
+
+            if (zone_filters.count(p) == 1)
+                query.add(zone_filters[p], Units::UnitQuery::EXPENSIVE, invert_filter);
+            else
+                query.addNamed(p, invert_filter);
+
+            out.color(COLOR_GREEN);
+            out << "Filter: '" << (invert_filter ? "not " : "") << desc << "'"
+                << endl;
+            out.reset_color();
+
+            invert_filter = false;
+        } else if (zone_param_filters.count(p) == 1) {
+            // get the constructor
+            auto &filter_pair = zone_param_filters[p];
+            auto arg_count = filter_pair.first;
+            auto &filter_constructor = filter_pair.second;
+            vector<string> args;
+
+            // get arguments
+            while (arg_count) {
+                i++;
+                arg_count--;
+                args.push_back(parameters[i]);
+            }
+
+            // get results
+            try {
+                string desc = filter_constructor(query, args, invert_filter);
+
+                out.color(COLOR_GREEN);
+                out << "Filter: '" << (invert_filter ? "not " : "") << desc << "'"
+                    << endl;
+                out.reset_color();
+
+                invert_filter = false;
+
+                if (p == "race") {
+                    race_filter_set = true;
+                }
+            } catch (const exception&) {
+                return CR_FAILURE;
+            }
         } else {
             out.printerr("Unknown command: %s\n", p.c_str());
             return CR_WRONG_USAGE;
@@ -1548,10 +1447,11 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
             return CR_FAILURE;
         }
 
-        active_filters.push_back([assigned_unit_ids](df::unit *unit) -> bool
+        query.add([assigned_unit_ids](df::unit *unit) -> bool
             {
                 return assigned_unit_ids.count(unit->id) == 1;
-            }
+            },
+            Units::UnitQuery::MODERATE
         );
     }
 
@@ -1575,10 +1475,11 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
             << endl;
         out.reset_color();
 
-        active_filters.push_back([](df::unit *unit)
+        query.add([](df::unit *unit)
             {
                 return !Units::isOwnRace(unit) || !Units::isOwnCiv(unit);
-            }
+            },
+            Units::UnitQuery::CHEAP
         );
     }
     if(!named_filter_set && unit_slaughter)
@@ -1589,11 +1490,7 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
             << endl;
         out.reset_color();
 
-        active_filters.push_back([](df::unit *unit)
-            {
-                return !unit->name.has_name;
-            }
-        );
+        query.addNamed("named", true);
     }
     if(!merchant_filter_set && (building_assign || cagezone_assign || unit_slaughter))
     {
@@ -1603,11 +1500,7 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
             << endl;
         out.reset_color();
 
-        active_filters.push_back([](df::unit *unit)
-            {
-                return !Units::isMerchant(unit) && !Units::isForest(unit);
-            }
-        );
+        query.addNamed("merchant", true);
     }
 
     if(building_assign || cagezone_assign || (nick_set && target_count == 0))
@@ -1640,26 +1533,8 @@ static command_result df_zone(color_ostream &out, vector <string> & parameters)
         {
             df::unit *unit = *unit_it;
 
-            // ignore inactive and undead units
-            if (!Units::isActive(unit) || Units::isUndead(unit)) {
-                continue;
-            }
-
-            bool passes_all_filters = true;
-
-            for (auto filter_it = active_filters.begin(); filter_it != active_filters.end(); ++filter_it)
-            {
-                auto &filter = *filter_it;
-
-                if (!filter(unit)) {
-                    passes_all_filters = false;
-                    break;
-                }
-            }
-
-            if (!passes_all_filters) {
+            if (!query.matches(unit))
                 continue;
-            }
 
             // animals bought in cages have an invalid map pos until they are freed for the first time
             // but if they are not in a cage and have an invalid pos it's better not to touch them
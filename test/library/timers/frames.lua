@@ -0,0 +1,107 @@
+-- tests the frame timers queued by dfhack.timeout and dfhack.interval
+
+config.target = 'core'
+
+local function recorder(fired)
+    return function(value)
+        return function() table.insert(fired, value) end
+    end
+end
+
+function test.interval_rearms_until_cancelled()
+    local fired = 0
+    local id = dfhack.interval(3, 'frames', function() fired = fired + 1 end)
+    delay(10)
+    expect.eq(3, fired)
+    expect.true_(dfhack.timeout_active(id))
+
+    dfhack.timeout_active(id, nil)
+    expect.nil_(dfhack.timeout_active(id))
+    delay(10)
+    expect.eq(3, fired)
+end
+
+function test.interval_cancelled_from_own_callback()
+    local fired = 0
+    local id
+    id = dfhack.interval(2, 'frames', function()
+        fired = fired + 1
+        if fired == 2 then dfhack.timeout_active(id, nil) end
+    end)
+    delay(10)
+    expect.eq(2, fired)
+    expect.nil_(dfhack.timeout_active(id))
+end
+
+function test.interval_keeps_replaced_callback()
+    local fired = {}
+    local record = recorder(fired)
+    local id = dfhack.interval(2, 'frames', record('old'))
+    delay(3)
+    dfhack.timeout_active(id, record('new'))
+    delay(4)
+    dfhack.timeout_active(id, nil)
+    expect.table_eq({'old', 'new', 'new'}, fired)
+end
+
+function test.timeouts_beyond_one_revolution()
+    local fired = {}
+    local record = recorder(fired)
+    -- the wheel has 256 slots: 266 shares a slot with 10, and 300 is due
+    -- more than a revolution out
+    dfhack.timeout(266, 'frames', record(266))
+    dfhack.timeout(10, 'frames', record(10))
+    dfhack.timeout(300, 'frames', record(300))
+    delay(265)
+    expect.table_eq({10}, fired)
+    delay(2)
+    expect.table_eq({10, 266}, fired)
+    delay(32)
+    expect.table_eq({10, 266}, fired)
+    delay(2)
+    expect.table_eq({10, 266, 300}, fired)
+end
+
+function test.interval_of_one_revolution()
+    -- re-arms into the slot it fired from
+    local fired = 0
+    local id = dfhack.interval(256, 'frames', function() fired = fired + 1 end)
+    delay(255)
+    expect.eq(0, fired)
+    delay(2)
+    expect.eq(1, fired)
+    delay(254)
+    expect.eq(1, fired)
+    delay(2)
+    expect.eq(2, fired)
+    dfhack.timeout_active(id, nil)
+end
+
+function test.callback_cancels_later_timers_in_same_batch()
+    local fired = {}
+    local record = recorder(fired)
+    local later, repeating
+    dfhack.timeout(5, 'frames', function()
+        table.insert(fired, 'first')
+        dfhack.timeout_active(later, nil)
+        dfhack.timeout_active(repeating, nil)
+    end)
+    later = dfhack.timeout(5, 'frames', record('later'))
+    repeating = dfhack.interval(5, 'frames', record('repeating'))
+    delay(12)
+    expect.table_eq({'first'}, fired)
+    expect.nil_(dfhack.timeout_active(later))
+    expect.nil_(dfhack.timeout_active(repeating))
+end
+
+function test.same_frame_fires_in_queue_order()
+    local fired = {}
+    local record = recorder(fired)
+    dfhack.timeout(4, 'frames', record(1))
+    local id = dfhack.interval(2, 'frames', record(2))
+    dfhack.timeout(4, 'frames', record(3))
+    delay(5)
+    dfhack.timeout_active(id, nil)
+    -- the interval was re-armed when it fired, after 3 was queued
+    expect.table_eq({2, 1, 3, 2}, fired)
+end
@@ -0,0 +1,49 @@
+-- tests the tick timers queued by dfhack.timeout and dfhack.interval
+
+config.target = 'core'
+config.mode = 'fortress'
+
+-- moves the game clock forward so that the next update collects everything
+-- due in the skipped stretch in one go. frame timers run before tick timers
+-- in the same update, so wait for the update after that one.
+local function skip_ticks(ticks)
+    df.global.world.frame_counter = df.global.world.frame_counter + ticks
+    delay(2)
+end
+
+function test.gap_fires_in_due_order()
+    local fired = {}
+    local function record(value)
+        return function() table.insert(fired, value) end
+    end
+    -- 300 and 520 are more than a revolution of the 256-slot wheel apart, so
+    -- 520 sits in a slot the wheel reaches first; 44 shares a slot with 300
+    dfhack.timeout(520, 'ticks', record(520))
+    dfhack.timeout(300, 'ticks', record(300))
+    dfhack.timeout(44, 'ticks', record(44))
+    dfhack.timeout(8, 'ticks', record(8))
+    skip_ticks(600)
+    expect.table_eq({8, 44, 300, 520}, fired)
+end
+
+function test.interval_fires_once_after_gap()
+    local fired = 0
+    local id = dfhack.interval(100, 'ticks', function() fired = fired + 1 end)
+    skip_ticks(1000)
+    expect.eq(1, fired)
+    skip_ticks(100)
+    expect.eq(2, fired)
+    dfhack.timeout_active(id, nil)
+end
+
+function test.cancelled_during_gap()
+    local fired = {}
+    local later
+    dfhack.timeout(10, 'ticks', function()
+        table.insert(fired, 10)
+        dfhack.timeout_active(later, nil)
+    end)
+    later = dfhack.timeout(400, 'ticks', function() table.insert(fired, 400) end)
+    skip_ticks(500)
+    expect.table_eq({10}, fired)
+end
@@ -0,0 +1,51 @@
+config.target = 'core'
+
+local raws = df.global.world.raws
+
+local function first_index(vec, field)
+    local found = {}
+    for i, raw in ipairs(vec) do
+        if found[raw[field]] == nil then
+            found[raw[field]] = i
+        end
+    end
+    return found
+end
+
+local function check_table(name, fn, vec, field)
+    for id, idx in pairs(first_index(vec, field)) do
+        expect.eq(idx, fn(id), ('%s %s'):format(name, id))
+    end
+    expect.eq(-1, fn('NOT_A_RAW_ID'), name)
+end
+
+function test.findRaws()
+    check_table('inorganic', dfhack.raws.findInorganic, raws.inorganics, 'id')
+    check_table('plant', dfhack.raws.findPlant, raws.plants.all, 'id')
+    check_table('creature', dfhack.raws.findCreature, raws.creatures.all, 'creature_id')
+end
+
+function test.findItemSubtype()
+    check_table('weapon', curry(dfhack.raws.findItemSubtype, df.item_type.WEAPON),
+        raws.itemdefs.weapons, 'id')
+    expect.eq(-1, dfhack.raws.findItemSubtype(df.item_type.BOULDER, 'NONE'))
+end
+
+function test.matinfoFindAll()
+    local tokens = {'INORGANIC:NOT_A_RAW_ID', 'COAL:CHARCOAL'}
+    for i, raw in ipairs(raws.inorganics) do
+        if i >= 10 then break end
+        table.insert(tokens, 'INORGANIC:' .. raw.id)
+    end
+
+    local found = dfhack.matinfo.findAll(tokens)
+    for _, token in ipairs(tokens) do
+        local info = dfhack.matinfo.find(token)
+        if info then
+            expect.eq(info.type, found[token].type, token)
+            expect.eq(info.index, found[token].index, token)
+        else
+            expect.nil_(found[token], token)
+        end
+    end
+end